@@ -37,6 +37,8 @@ GOMP_barrier (void)
   if (team == NULL)
     return;
 
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    thr->tool_site = __builtin_return_address (0);
   gomp_team_barrier_wait (&team->barrier);
 }
 
@@ -49,5 +51,7 @@ GOMP_barrier_cancel (void)
   /* The compiler transforms to barrier_cancel when it sees that the
      barrier is within a construct that can cancel.  Thus we should
      never have an orphaned cancellable barrier.  */
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    thr->tool_site = __builtin_return_address (0);
   return gomp_team_barrier_wait_cancel (&team->barrier);
 }
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/syscall.h>
 
 #ifdef HAVE_PTHREAD_AFFINITY_NP
 
@@ -44,15 +45,24 @@
 #define CPU_CLR_S(idx, size, set) CPU_CLR(idx, set)
 #endif
 
+/* Build the places if OMP_PLACES and GOMP_CPU_AFFINITY did not.  No
+   thread is bound here, as this runs in whatever thread first uses the
+   runtime; the masters of teams are bound as they start their first
+   team, see gomp_init_master_affinity.  */
+
 void
 gomp_init_affinity (void)
 {
   if (gomp_places_list == NULL)
-    {
-      if (!gomp_affinity_init_level (1, ULONG_MAX, true))
-	return;
-    }
+    gomp_affinity_init_level (1, ULONG_MAX, true);
+}
 
+/* Bind the calling thread, which starts a team without having been
+   given a place, to the first place.  */
+
+void
+gomp_init_master_affinity (void)
+{
   struct gomp_thread *thr = gomp_thread ();
   pthread_setaffinity_np (pthread_self (), gomp_cpuset_size,
 			  (cpu_set_t *) gomp_places_list[0]);
@@ -252,68 +262,39 @@ gomp_affinity_init_level (int level, unsigned long count, bool quiet)
     }
   else
     {
-      char name[sizeof ("/sys/devices/system/cpu/cpu/topology/"
-			"thread_siblings_list") + 3 * sizeof (unsigned long)];
-      size_t prefix_len = sizeof ("/sys/devices/system/cpu/cpu") - 1;
+      /* OMP_PLACES levels 2 to 5 are cores, sockets, last level caches
+	 and NUMA domains.  */
+      static const enum gomp_topology_level levels[]
+	= { GOMP_TOPOLOGY_CORE, GOMP_TOPOLOGY_SOCKET, GOMP_TOPOLOGY_L3,
+	    GOMP_TOPOLOGY_NUMA };
+      const struct gomp_topology *topo = gomp_get_topology ();
+      enum gomp_topology_level tlevel = levels[level - 2];
       cpu_set_t *copy = gomp_alloca (gomp_cpuset_size);
-      FILE *f;
-      char *line = NULL;
-      size_t linelen = 0;
+      unsigned long j;
 
-      memcpy (name, "/sys/devices/system/cpu/cpu", prefix_len);
       memcpy (copy, gomp_cpusetp, gomp_cpuset_size);
       for (i = 0; i < max && gomp_places_list_len < count; i++)
 	if (CPU_ISSET_S (i, gomp_cpuset_size, copy))
 	  {
-	    sprintf (name + prefix_len, "%lu/topology/%s_siblings_list",
-		     i, level == 2 ? "thread" : "core");
-	    f = fopen (name, "r");
-	    if (f != NULL)
-	      {
-		if (getline (&line, &linelen, f) > 0)
-		  {
-		    char *p = line;
-		    bool seen_i = false;
-		    void *pl = gomp_places_list[gomp_places_list_len];
-		    gomp_affinity_init_place (pl);
-		    while (*p && *p != '\n')
-		      {
-			unsigned long first, last;
-			errno = 0;
-			first = strtoul (p, &p, 10);
-			if (errno)
-			  break;
-			last = first;
-			if (*p == '-')
-			  {
-			    errno = 0;
-			    last = strtoul (p + 1, &p, 10);
-			    if (errno || last < first)
-			      break;
-			  }
-			for (; first <= last; first++)
-			  if (CPU_ISSET_S (first, gomp_cpuset_size, copy)
-			      && gomp_affinity_add_cpus (pl, first, 1, 0,
-							 true))
-			    {
-			      CPU_CLR_S (first, gomp_cpuset_size, copy);
-			      if (first == i)
-				seen_i = true;
-			    }
-			if (*p == ',')
-			  ++p;
-		      }
-		    if (seen_i)
-		      gomp_places_list_len++;
-		  }
-		fclose (f);
-	      }
+	    int domain = gomp_topology_domain (topo, tlevel, i);
+	    void *pl = gomp_places_list[gomp_places_list_len];
+
+	    if (domain < 0)
+	      continue;
+	    gomp_affinity_init_place (pl);
+	    for (j = i; j < max && j < topo->ncpus; j++)
+	      if (CPU_ISSET_S (j, gomp_cpuset_size, copy)
+		  && gomp_topology_domain (topo, tlevel, j) == domain
+		  && gomp_affinity_add_cpus (pl, j, 1, 0, true))
+		CPU_CLR_S (j, gomp_cpuset_size, copy);
+	    gomp_places_list_len++;
 	  }
       if (gomp_places_list_len == 0)
 	{
+	  static const char *const kinds[]
+	    = { "core", "socket", "last level cache", "NUMA" };
 	  if (!quiet)
-	    gomp_error ("Error reading %s topology",
-			level == 2 ? "core" : "socket");
+	    gomp_error ("Error reading %s topology", kinds[level - 2]);
 	  free (gomp_places_list);
 	  gomp_places_list = NULL;
 	  return false;
@@ -352,6 +333,157 @@ gomp_affinity_print_place (void *p)
     fprintf (stderr, ":%lu", len);
 }
 
+/* NUMA node of the first CPU of each place, or -1 if unknown, computed
+   on first use by gomp_affinity_place_of_address.  */
+static int *gomp_places_node;
+/* True if the places whose node is known are not all on the same node.  */
+static bool gomp_places_multinode;
+static gomp_mutex_t gomp_places_node_lock;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_affinity (void)
+{
+  gomp_mutex_init (&gomp_places_node_lock);
+}
+#endif
+
+static int *
+gomp_affinity_init_places_node (void)
+{
+  const struct gomp_topology *topo = gomp_get_topology ();
+  int *nodes = gomp_malloc (gomp_places_list_len * sizeof (int));
+  unsigned long i, cpu, max = 8 * gomp_cpuset_size;
+  int first = -1;
+
+  for (i = 0; i < gomp_places_list_len; i++)
+    {
+      cpu_set_t *cpusetp = (cpu_set_t *) gomp_places_list[i];
+
+      nodes[i] = -1;
+      for (cpu = 0; cpu < max; cpu++)
+	if (CPU_ISSET_S (cpu, gomp_cpuset_size, cpusetp))
+	  break;
+      if (cpu < max)
+	{
+	  int domain = gomp_topology_domain (topo, GOMP_TOPOLOGY_NUMA, cpu);
+	  if (domain >= 0)
+	    nodes[i] = topo->numa_node[domain];
+	}
+      if (nodes[i] == -1)
+	continue;
+      if (first == -1)
+	first = nodes[i];
+      else if (nodes[i] != first)
+	gomp_places_multinode = true;
+    }
+  return nodes;
+}
+
+/* Return gomp_places_node, computing it on the first call.  */
+
+static int *
+gomp_affinity_places_node (void)
+{
+  int *nodes = __atomic_load_n (&gomp_places_node, MEMMODEL_ACQUIRE);
+
+  if (nodes == NULL)
+    {
+      gomp_mutex_lock (&gomp_places_node_lock);
+      nodes = gomp_places_node;
+      if (nodes == NULL)
+	{
+	  nodes = gomp_affinity_init_places_node ();
+	  __atomic_store_n (&gomp_places_node, nodes, MEMMODEL_RELEASE);
+	}
+      gomp_mutex_unlock (&gomp_places_node_lock);
+    }
+  return nodes;
+}
+
+/* Return true if there is a place-list whose places are not all on the
+   same NUMA node.  */
+
+bool
+gomp_affinity_multinode_p (void)
+{
+  if (gomp_places_list == NULL)
+    return false;
+  gomp_affinity_places_node ();
+  return gomp_places_multinode;
+}
+
+/* Return the NUMA node of place PLACE, or -1 if it is unknown or the
+   places are all on the same node.  */
+
+int
+gomp_affinity_place_node (unsigned long place)
+{
+  if (!gomp_affinity_multinode_p ())
+    return -1;
+  return gomp_places_node[place];
+}
+
+/* Move the pages holding SIZE bytes at ADDR to the NUMA node the calling
+   thread runs on.  Used for data of a thread bound to a place that has
+   been first touched by another thread.  */
+
+void
+gomp_affinity_move_local (void *addr, size_t size)
+{
+#if defined SYS_move_pages && defined SYS_getcpu
+  uintptr_t page = sysconf (_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t) addr & -page;
+  unsigned long i, count = ((uintptr_t) addr + size - start + page - 1) / page;
+  void **pages = gomp_alloca (count * sizeof (void *));
+  int *nodes = gomp_alloca (count * sizeof (int));
+  int *status = gomp_alloca (count * sizeof (int));
+  unsigned int cpu, node;
+
+  if (syscall (SYS_getcpu, &cpu, &node, NULL) != 0)
+    return;
+  for (i = 0; i < count; i++)
+    {
+      pages[i] = (void *) (start + i * page);
+      nodes[i] = node;
+    }
+  syscall (SYS_move_pages, 0, count, pages, nodes, status, 0);
+#else
+  (void) addr;
+  (void) size;
+#endif
+}
+
+/* Return the index in gomp_places_list of the first place on the NUMA
+   node holding the memory at ADDR, or -1 if the places are all on the
+   same node or the node of ADDR is unknown, e.g. because it has not been
+   touched yet.  */
+
+int
+gomp_affinity_place_of_address (const void *addr)
+{
+  int *nodes;
+  int status = -1;
+  unsigned long i;
+
+  if (!gomp_affinity_multinode_p ())
+    return -1;
+  nodes = gomp_places_node;
+
+#ifdef SYS_move_pages
+  /* Without a list of target nodes, move_pages only reports the node
+     each page is on.  */
+  if (syscall (SYS_move_pages, 0, 1UL, &addr, NULL, &status, 0) != 0)
+    return -1;
+#endif
+  if (status < 0)
+    return -1;
+  for (i = 0; i < gomp_places_list_len; i++)
+    if (nodes[i] == status)
+      return i;
+  return -1;
+}
+
 #else
 
 #include "../posix/affinity.c"
@@ -76,8 +76,9 @@ gomp_team_barrier_wake (gomp_barrier_t *bar, int count)
   futex_wake ((int *) &bar->generation, count == 0 ? INT_MAX : count);
 }
 
-void
-gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
+static void
+gomp_team_barrier_wait_end_1 (gomp_barrier_t *bar,
+			      gomp_barrier_state_t state)
 {
   unsigned int generation, gen;
 
@@ -135,9 +136,9 @@ gomp_team_barrier_wait_final (gomp_barrier_t *bar)
   gomp_team_barrier_wait_end (bar, state);
 }
 
-bool
-gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
-				   gomp_barrier_state_t state)
+static bool
+gomp_team_barrier_wait_cancel_end_1 (gomp_barrier_t *bar,
+				     gomp_barrier_state_t state)
 {
   unsigned int generation, gen;
 
@@ -189,6 +190,32 @@ gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
   return false;
 }
 
+/* The team barrier waits are reported to the tool, if any.  */
+
+void
+gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
+{
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_begin (bar);
+  gomp_team_barrier_wait_end_1 (bar, state);
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_end (bar);
+}
+
+bool
+gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
+				   gomp_barrier_state_t state)
+{
+  bool ret;
+
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_begin (bar);
+  ret = gomp_team_barrier_wait_cancel_end_1 (bar, state);
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_end (bar);
+  return ret;
+}
+
 bool
 gomp_team_barrier_wait_cancel (gomp_barrier_t *bar)
 {
@@ -0,0 +1,277 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a Linux specific implementation of the thread budget shared
+   by the processes of a user on a node, see GOMP_NODE_BUDGET.  The
+   processes register their active threads in a file in /dev/shm.  */
+
+#include "libgomp.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define GOMP_NODE_BUDGET_SLOTS 256
+
+struct gomp_node_slot
+{
+  /* Process using the slot, 0 if free, or -1 while a slot left by a
+     process that died is being freed.  */
+  int pid;
+  /* Threads it runs: its initial thread plus those of its active
+     top-level teams.  */
+  unsigned int nthreads;
+};
+
+/* The shared segment.  It is zero when created, which is a valid empty
+   state, so there is nothing to initialize.  */
+
+struct gomp_node_budget
+{
+  /* Sum of the nthreads fields of the slots.  */
+  unsigned long active;
+  struct gomp_node_slot slots[GOMP_NODE_BUDGET_SLOTS];
+};
+
+unsigned long *gomp_node_active;
+static struct gomp_node_budget *gomp_node_budget;
+/* Slot of this process, or NULL in a child created by fork until it
+   starts its first top-level team.  */
+static struct gomp_node_slot *gomp_node_slot;
+/* Time of the last search for slots of dead processes.  */
+static double gomp_node_reclaim_time;
+
+/* Free the slots of processes that died without releasing them.
+   Processes sharing the segment must share a PID namespace.  */
+
+static void
+gomp_node_budget_reclaim (void)
+{
+  unsigned int i;
+
+  for (i = 0; i < GOMP_NODE_BUDGET_SLOTS; i++)
+    {
+      struct gomp_node_slot *slot = &gomp_node_budget->slots[i];
+      int pid = __atomic_load_n (&slot->pid, MEMMODEL_ACQUIRE);
+      unsigned int n;
+
+      if (pid <= 0 || kill (pid, 0) == 0 || errno != ESRCH
+	  || !__atomic_compare_exchange_n (&slot->pid, &pid, -1, false,
+					   MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
+	continue;
+      n = slot->nthreads;
+      slot->nthreads = 0;
+      __atomic_sub_fetch (gomp_node_active, n, MEMMODEL_RELEASE);
+      __atomic_store_n (&slot->pid, 0, MEMMODEL_RELEASE);
+    }
+}
+
+/* Claim a slot for the calling process, registering its initial
+   thread, and return it.  Return NULL if there is none left.  */
+
+static struct gomp_node_slot *
+gomp_node_budget_claim (void)
+{
+  int pid = getpid ();
+  unsigned int i, pass;
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      if (pass)
+	gomp_node_budget_reclaim ();
+      for (i = 0; i < GOMP_NODE_BUDGET_SLOTS; i++)
+	{
+	  struct gomp_node_slot *slot = &gomp_node_budget->slots[i];
+	  int free_pid = 0;
+	  if (__atomic_compare_exchange_n (&slot->pid, &free_pid, pid, false,
+					   MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
+	    {
+	      __atomic_store_n (&slot->nthreads, 1, MEMMODEL_RELAXED);
+	      __atomic_add_fetch (gomp_node_active, 1, MEMMODEL_RELEASE);
+	      return slot;
+	    }
+	}
+    }
+  gomp_error ("No free slot in the GOMP_NODE_BUDGET segment");
+  return NULL;
+}
+
+/* Unregister the threads of SLOT and free it.  */
+
+static void
+gomp_node_budget_unclaim (struct gomp_node_slot *slot)
+{
+  unsigned int n;
+
+  n = __atomic_exchange_n (&slot->nthreads, 0, MEMMODEL_RELAXED);
+  __atomic_sub_fetch (gomp_node_active, n, MEMMODEL_RELEASE);
+  __atomic_store_n (&slot->pid, 0, MEMMODEL_RELEASE);
+}
+
+/* A child created by fork has only one thread and must not account in
+   the slot of its parent.  It only claims a slot of its own when it
+   starts a top-level team, see gomp_node_budget_acquire, so that
+   children that just exec another program, as with system or popen,
+   don't leave a slot behind.  The threads of a team the forking thread
+   was in belong to the parent.  */
+
+static void
+gomp_node_budget_atfork_child (void)
+{
+  gomp_node_slot = NULL;
+  gomp_thread ()->node_threads = 0;
+}
+
+static void __attribute__((destructor))
+gomp_node_budget_fini (void)
+{
+  if (gomp_node_active != NULL && gomp_node_slot != NULL)
+    gomp_node_budget_unclaim (gomp_node_slot);
+}
+
+/* Map the segment of the current user and register the process in it.
+   The file must be a regular file of the user that only the user can
+   access, so that other users can't make the process run with fewer
+   threads or crash it.  On failure the budget is silently ignored.  */
+
+void
+gomp_init_node_budget (void)
+{
+  char name[sizeof ("/dev/shm/libgomp-budget.") + 3 * sizeof (uid_t)];
+  struct stat st;
+  void *p;
+  int fd;
+
+  if (gomp_node_budget_var == ULONG_MAX)
+    {
+      long n = sysconf (_SC_NPROCESSORS_ONLN);
+      gomp_node_budget_var = n > 0 ? n : 1;
+    }
+
+  sprintf (name, "/dev/shm/libgomp-budget.%lu", (unsigned long) getuid ());
+  fd = open (name, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+  if (fd < 0)
+    return;
+  if (fstat (fd, &st) != 0
+      || st.st_uid != getuid ()
+      || !S_ISREG (st.st_mode)
+      || (st.st_mode & 07777) != 0600
+      || ftruncate (fd, sizeof (struct gomp_node_budget)) != 0)
+    {
+      close (fd);
+      return;
+    }
+  p = mmap (NULL, sizeof (struct gomp_node_budget), PROT_READ | PROT_WRITE,
+	    MAP_SHARED, fd, 0);
+  close (fd);
+  if (p == MAP_FAILED)
+    return;
+
+  gomp_node_budget = p;
+  gomp_node_active = &gomp_node_budget->active;
+  gomp_node_slot = gomp_node_budget_claim ();
+  if (gomp_node_slot == NULL)
+    {
+      gomp_node_active = NULL;
+      return;
+    }
+  pthread_atfork (NULL, NULL, gomp_node_budget_atfork_child);
+}
+
+/* Register the threads of a new top-level team of at most NTHREADS
+   threads, the calling thread included, and return its size.  If
+   RESIZE, the team is made smaller so that the active threads of all
+   processes, the teams other threads of this process already run
+   included, stay within the budget, down to the calling thread alone;
+   else NTHREADS threads are registered regardless.  */
+
+unsigned
+gomp_node_budget_acquire (unsigned nthreads, bool resize)
+{
+  struct gomp_node_slot *slot;
+  unsigned long active, avail;
+  unsigned ret;
+
+  slot = __atomic_load_n (&gomp_node_slot, MEMMODEL_ACQUIRE);
+  if (__builtin_expect (slot == NULL, 0))
+    {
+      struct gomp_node_slot *cur = NULL;
+
+      slot = gomp_node_budget_claim ();
+      if (slot == NULL)
+	{
+	  /* Run without the budget, as if it had failed at startup.  */
+	  gomp_node_active = NULL;
+	  return nthreads;
+	}
+      if (!__atomic_compare_exchange_n (&gomp_node_slot, &cur, slot, false,
+					MEMMODEL_ACQ_REL, MEMMODEL_ACQUIRE))
+	{
+	  /* Another thread of the child claimed one at the same time.  */
+	  gomp_node_budget_unclaim (slot);
+	  slot = cur;
+	}
+    }
+  active = __atomic_load_n (gomp_node_active, MEMMODEL_RELAXED);
+  do
+    {
+      /* All the active threads but the calling one, which is already
+	 running.  */
+      avail = active - 1 < gomp_node_budget_var
+	      ? gomp_node_budget_var - (active - 1) : 1;
+      ret = resize && avail < nthreads ? avail : nthreads;
+    }
+  while (!__atomic_compare_exchange_n (gomp_node_active, &active,
+				       active + ret - 1, false,
+				       MEMMODEL_ACQ_REL, MEMMODEL_RELAXED));
+  __atomic_add_fetch (&slot->nthreads, ret - 1, MEMMODEL_RELAXED);
+
+  /* A process that died while running a team leaves its threads
+     registered; look for those at most once a second when the node
+     seems full.  */
+  if (avail <= 1)
+    {
+      double now = omp_get_wtime ();
+      if (now - gomp_node_reclaim_time >= 1.0)
+	{
+	  gomp_node_reclaim_time = now;
+	  gomp_node_budget_reclaim ();
+	}
+    }
+  return ret;
+}
+
+/* Unregister NTHREADS threads of a top-level team that has ended.  */
+
+void
+gomp_node_budget_release (unsigned nthreads)
+{
+  if (gomp_node_active == NULL)
+    return;
+  __atomic_sub_fetch (&gomp_node_slot->nthreads, nthreads, MEMMODEL_RELAXED);
+  __atomic_sub_fetch (gomp_node_active, nthreads, MEMMODEL_RELEASE);
+}
@@ -0,0 +1,243 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a Linux specific implementation of user-level contexts for
+   untied tasks.  Stacks are mmapped with a guard page below them and
+   kept in a pool once their task has finished.  */
+
+#include "libgomp.h"
+#include "context.h"
+
+#ifdef GOMP_HAVE_TASK_CONTEXT
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+extern void gomp_context_start (void) attribute_hidden;
+
+#if defined __x86_64__
+/* Callee-saved registers are pushed in the order %rbp, %rbx, %r12-%r15,
+   followed by the SSE and x87 control words.  A new context starts in
+   gomp_context_start with the function in %r12 and its argument in
+   %r13.  */
+__asm__ (
+"	.text\n"
+"	.p2align 4\n"
+"	.globl	gomp_context_switch\n"
+"	.hidden	gomp_context_switch\n"
+"	.type	gomp_context_switch, @function\n"
+"gomp_context_switch:\n"
+"	pushq	%rbp\n"
+"	pushq	%rbx\n"
+"	pushq	%r12\n"
+"	pushq	%r13\n"
+"	pushq	%r14\n"
+"	pushq	%r15\n"
+"	subq	$8, %rsp\n"
+"	stmxcsr	(%rsp)\n"
+"	fnstcw	4(%rsp)\n"
+"	movq	%rsp, (%rdi)\n"
+"	movq	%rsi, %rsp\n"
+"	ldmxcsr	(%rsp)\n"
+"	fldcw	4(%rsp)\n"
+"	addq	$8, %rsp\n"
+"	popq	%r15\n"
+"	popq	%r14\n"
+"	popq	%r13\n"
+"	popq	%r12\n"
+"	popq	%rbx\n"
+"	popq	%rbp\n"
+"	ret\n"
+"	.size	gomp_context_switch, .-gomp_context_switch\n"
+"	.p2align 4\n"
+"	.globl	gomp_context_start\n"
+"	.hidden	gomp_context_start\n"
+"	.type	gomp_context_start, @function\n"
+"gomp_context_start:\n"
+"	movq	%r13, %rdi\n"
+"	call	*%r12\n"
+"	ud2\n"
+"	.size	gomp_context_start, .-gomp_context_start\n");
+
+#define GOMP_CONTEXT_FRAME_SIZE 64
+
+static void
+gomp_context_init_frame (void **frame, void (*fn) (void *), void *arg)
+{
+  memset (frame, 0, GOMP_CONTEXT_FRAME_SIZE);
+  /* Default MXCSR and x87 control word.  */
+  ((unsigned int *) frame)[0] = 0x1f80;
+  ((unsigned short *) frame)[2] = 0x037f;
+  frame[4] = (void *) fn;
+  frame[3] = arg;
+  frame[7] = (void *) gomp_context_start;
+}
+
+#elif defined __aarch64__
+/* Callee-saved registers x19-x30 and d8-d15 are stored in a 160 byte
+   frame.  A new context starts in gomp_context_start with the function
+   in x19 and its argument in x20.  */
+__asm__ (
+"	.text\n"
+"	.p2align 2\n"
+"	.globl	gomp_context_switch\n"
+"	.hidden	gomp_context_switch\n"
+"	.type	gomp_context_switch, %function\n"
+"gomp_context_switch:\n"
+"	sub	sp, sp, #160\n"
+"	stp	x19, x20, [sp, #0]\n"
+"	stp	x21, x22, [sp, #16]\n"
+"	stp	x23, x24, [sp, #32]\n"
+"	stp	x25, x26, [sp, #48]\n"
+"	stp	x27, x28, [sp, #64]\n"
+"	stp	x29, x30, [sp, #80]\n"
+"	stp	d8, d9, [sp, #96]\n"
+"	stp	d10, d11, [sp, #112]\n"
+"	stp	d12, d13, [sp, #128]\n"
+"	stp	d14, d15, [sp, #144]\n"
+"	mov	x2, sp\n"
+"	str	x2, [x0]\n"
+"	mov	sp, x1\n"
+"	ldp	x19, x20, [sp, #0]\n"
+"	ldp	x21, x22, [sp, #16]\n"
+"	ldp	x23, x24, [sp, #32]\n"
+"	ldp	x25, x26, [sp, #48]\n"
+"	ldp	x27, x28, [sp, #64]\n"
+"	ldp	x29, x30, [sp, #80]\n"
+"	ldp	d8, d9, [sp, #96]\n"
+"	ldp	d10, d11, [sp, #112]\n"
+"	ldp	d12, d13, [sp, #128]\n"
+"	ldp	d14, d15, [sp, #144]\n"
+"	add	sp, sp, #160\n"
+"	ret\n"
+"	.size	gomp_context_switch, .-gomp_context_switch\n"
+"	.p2align 2\n"
+"	.globl	gomp_context_start\n"
+"	.hidden	gomp_context_start\n"
+"	.type	gomp_context_start, %function\n"
+"gomp_context_start:\n"
+"	mov	x0, x20\n"
+"	blr	x19\n"
+"	brk	#1000\n"
+"	.size	gomp_context_start, .-gomp_context_start\n");
+
+#define GOMP_CONTEXT_FRAME_SIZE 160
+
+static void
+gomp_context_init_frame (void **frame, void (*fn) (void *), void *arg)
+{
+  memset (frame, 0, GOMP_CONTEXT_FRAME_SIZE);
+  frame[0] = (void *) fn;
+  frame[1] = arg;
+  frame[11] = (void *) gomp_context_start;
+}
+#endif
+
+static gomp_mutex_t gomp_context_pool_lock;
+static struct gomp_context *gomp_context_pool;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_context (void)
+{
+  gomp_mutex_init (&gomp_context_pool_lock);
+}
+#endif
+
+struct gomp_context *
+gomp_context_new (void (*fn) (void *), void *arg)
+{
+  struct gomp_context *ctx;
+  char *top;
+
+  gomp_mutex_lock (&gomp_context_pool_lock);
+  ctx = gomp_context_pool;
+  if (ctx)
+    gomp_context_pool = ctx->next_free;
+  gomp_mutex_unlock (&gomp_context_pool_lock);
+
+  if (ctx == NULL)
+    {
+      size_t page = sysconf (_SC_PAGESIZE);
+      size_t size = (gomp_task_stacksize_var + page - 1) & ~(page - 1);
+      char *base = mmap (NULL, size + page, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+
+      if (base == MAP_FAILED)
+	gomp_fatal ("Out of memory allocating %lu bytes of task stack",
+		    (unsigned long) (size + page));
+      /* Guard page to catch stack overflows.  */
+      mprotect (base, page, PROT_NONE);
+      ctx = (struct gomp_context *) (base + page + size) - 1;
+    }
+
+  ctx->done = false;
+  top = (char *) ((uintptr_t) ctx & ~(uintptr_t) 15);
+  ctx->sp = top - GOMP_CONTEXT_FRAME_SIZE - 16;
+  gomp_context_init_frame (ctx->sp, fn, arg);
+  return ctx;
+}
+
+void
+gomp_context_free (struct gomp_context *ctx)
+{
+  gomp_mutex_lock (&gomp_context_pool_lock);
+  ctx->next_free = gomp_context_pool;
+  gomp_context_pool = ctx;
+  gomp_mutex_unlock (&gomp_context_pool_lock);
+}
+
+void
+gomp_context_pool_release (bool hard)
+{
+  size_t page = sysconf (_SC_PAGESIZE);
+  size_t size = (gomp_task_stacksize_var + page - 1) & ~(page - 1);
+  struct gomp_context *ctx, *next;
+
+  /* The context structure is at the top of its stack, below which are
+     the stack and the guard page.  A soft release keeps the page of the
+     structure, and the pool locked so that no stack is taken from it
+     meanwhile.  */
+  gomp_mutex_lock (&gomp_context_pool_lock);
+  ctx = gomp_context_pool;
+  if (hard)
+    {
+      gomp_context_pool = NULL;
+      gomp_mutex_unlock (&gomp_context_pool_lock);
+    }
+  for (; ctx != NULL; ctx = next)
+    {
+      char *base = (char *) (ctx + 1) - size - page;
+      next = ctx->next_free;
+      if (hard)
+	munmap (base, size + page);
+      else
+	madvise (base + page, ((uintptr_t) ctx & ~(page - 1))
+			      - (uintptr_t) (base + page), MADV_DONTNEED);
+    }
+  if (!hard)
+    gomp_mutex_unlock (&gomp_context_pool_lock);
+}
+
+#endif /* GOMP_HAVE_TASK_CONTEXT */
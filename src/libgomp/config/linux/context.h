@@ -0,0 +1,72 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a Linux specific implementation of user-level contexts, used
+   to suspend untied tasks and resume them on any thread of the team.
+   Only the callee-saved registers are switched, by a small assembly
+   routine, on targets for which one is provided.  */
+
+#ifndef GOMP_CONTEXT_H
+#define GOMP_CONTEXT_H 1
+
+#if defined __x86_64__ || defined __aarch64__
+# define GOMP_HAVE_TASK_CONTEXT 1
+
+#ifdef HAVE_ATTRIBUTE_VISIBILITY
+# pragma GCC visibility push(hidden)
+#endif
+
+struct gomp_context
+{
+  /* Stack pointer of the context while it is switched out.  */
+  void *sp;
+  /* Stack pointer of the context that last switched to this one, which
+     is where it goes back to when it suspends or finishes.  */
+  void *caller_sp;
+  /* Set once the function the context was created for has returned.  */
+  bool done;
+  /* Link in the pool of free contexts.  */
+  struct gomp_context *next_free;
+};
+
+/* Return a context with a stack of gomp_task_stacksize_var bytes that,
+   when first switched to, calls FN (ARG).  FN must not return; it has to
+   switch away for good instead.  */
+extern struct gomp_context *gomp_context_new (void (*) (void *), void *);
+/* Put a context that will never be switched to again back into the
+   pool.  */
+extern void gomp_context_free (struct gomp_context *);
+/* Release the stacks of the contexts in the pool: with HARD unmap them,
+   else only give their pages back to the system.  */
+extern void gomp_context_pool_release (bool);
+/* Save the current context, storing its stack pointer to *SAVE_SP, and
+   continue the context whose stack pointer is SP.  */
+extern void gomp_context_switch (void **, void *);
+
+#ifdef HAVE_ATTRIBUTE_VISIBILITY
+# pragma GCC visibility pop
+#endif
+
+#endif /* __x86_64__ || __aarch64__ */
+
+#endif /* GOMP_CONTEXT_H */
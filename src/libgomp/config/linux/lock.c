@@ -50,12 +50,22 @@ gomp_destroy_lock_30 (omp_lock_t *lock)
 void
 gomp_set_lock_30 (omp_lock_t *lock)
 {
-  gomp_mutex_lock (lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
+  if (!gomp_tool_mutex_trylock (lock))
+    gomp_mutex_lock (lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
 gomp_unset_lock_30 (omp_lock_t *lock)
 {
+  gomp_tool_event (gomp_tool_event_lock_release, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
   gomp_mutex_unlock (lock);
 }
 
@@ -64,8 +74,13 @@ gomp_test_lock_30 (omp_lock_t *lock)
 {
   int oldval = 0;
 
-  return __atomic_compare_exchange_n (lock, &oldval, 1, false,
-				      MEMMODEL_ACQUIRE, MEMMODEL_RELAXED);
+  if (!__atomic_compare_exchange_n (lock, &oldval, 1, false,
+				    MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
+    return 0;
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_lock_tested (lock, gomp_tool_mutex_lock,
+			   (unsigned long) __builtin_return_address (0));
+  return 1;
 }
 
 void
@@ -86,7 +101,14 @@ gomp_set_nest_lock_30 (omp_nest_lock_t *lock)
 
   if (lock->owner != me)
     {
-      gomp_mutex_lock (&lock->lock);
+      gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
+      if (!gomp_tool_mutex_trylock (&lock->lock))
+	gomp_mutex_lock (&lock->lock);
+      gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
     }
 
@@ -98,6 +120,9 @@ gomp_unset_nest_lock_30 (omp_nest_lock_t *lock)
 {
   if (--lock->count == 0)
     {
+      gomp_tool_event (gomp_tool_event_lock_release, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = NULL;
       gomp_mutex_unlock (&lock->lock);
     }
@@ -116,6 +141,9 @@ gomp_test_nest_lock_30 (omp_nest_lock_t *lock)
   if (__atomic_compare_exchange_n (&lock->lock, &oldval, 1, false,
 				   MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
     {
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	gomp_tool_lock_tested (lock, gomp_tool_mutex_nest_lock,
+			       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
       lock->count = 1;
       return 1;
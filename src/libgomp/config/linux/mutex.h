@@ -56,6 +56,16 @@ gomp_mutex_lock (gomp_mutex_t *mutex)
     gomp_mutex_lock_slow (mutex, oldval);
 }
 
+/* Take MUTEX if it is free, and return whether it was.  */
+
+static inline bool
+gomp_mutex_trylock (gomp_mutex_t *mutex)
+{
+  int oldval = 0;
+  return __atomic_compare_exchange_n (mutex, &oldval, 1, false,
+				      MEMMODEL_ACQUIRE, MEMMODEL_RELAXED);
+}
+
 static inline void
 gomp_mutex_unlock (gomp_mutex_t *mutex)
 {
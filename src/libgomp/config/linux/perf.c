@@ -0,0 +1,167 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a Linux specific implementation of the performance counters of
+   a thread, opened with perf_event_open.  The hardware counters are read
+   as one group and the software counters as another, so that a thread
+   still has the latter where the processor's counters are unavailable,
+   e.g. in virtual machines or under a strict perf_event_paranoid.  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include "libgomp.h"
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* The counters in the order of gomp_perf_counter_t, and the group each
+   belongs to, the first of a group leading it.  */
+
+static const struct
+{
+  unsigned int type;
+  unsigned long long config;
+  int group;
+} gomp_perf_events[GOMP_PERF_COUNTERS] =
+{
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0 },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0 },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 0 },
+  { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, 1 },
+  { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, 1 }
+};
+
+struct gomp_perf_thread
+{
+  /* File descriptor of each counter, or -1 if it is unavailable.  */
+  int fd[GOMP_PERF_COUNTERS];
+  /* Counters available, as a mask of 1 << index.  */
+  unsigned int mask;
+};
+
+static int
+gomp_perf_open (int index, int group_fd)
+{
+#ifdef __NR_perf_event_open
+  struct perf_event_attr attr;
+
+  memset (&attr, 0, sizeof (attr));
+  attr.size = sizeof (attr);
+  attr.type = gomp_perf_events[index].type;
+  attr.config = gomp_perf_events[index].config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall (__NR_perf_event_open, &attr, 0, -1, group_fd,
+		  PERF_FLAG_FD_CLOEXEC);
+#else
+  return -1;
+#endif
+}
+
+/* Open the counters of the calling thread THR.  */
+
+static struct gomp_perf_thread *
+gomp_perf_init_thread (struct gomp_thread *thr)
+{
+  struct gomp_perf_thread *pt = gomp_malloc (sizeof (*pt));
+  int i;
+
+  pt->mask = 0;
+  for (i = 0; i < GOMP_PERF_COUNTERS; i++)
+    {
+      int leader = i;
+
+      while (leader > 0
+	     && gomp_perf_events[leader - 1].group == gomp_perf_events[i].group)
+	leader--;
+      /* Members of a group whose leader failed are not opened.  */
+      if (leader != i && pt->fd[leader] < 0)
+	pt->fd[i] = -1;
+      else
+	pt->fd[i] = gomp_perf_open (i, leader == i ? -1 : pt->fd[leader]);
+      if (pt->fd[i] >= 0)
+	pt->mask |= 1U << i;
+    }
+  thr->perf = pt;
+  gomp_free_thread_at_exit (thr);
+  return pt;
+}
+
+/* Store the current values of the counters of the calling thread in
+   VALUES, opening them on first use.  Return the mask of the counters
+   available; the others are set to 0.  */
+
+unsigned int
+gomp_perf_read (uint64_t *values)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_perf_thread *pt = thr->perf;
+  int i;
+
+  if (__builtin_expect (pt == NULL, 0))
+    pt = gomp_perf_init_thread (thr);
+
+  memset (values, 0, GOMP_PERF_COUNTERS * sizeof (*values));
+  for (i = 0; i < GOMP_PERF_COUNTERS; i++)
+    {
+      /* The number of counters of the group, then the values of those
+	 that were opened, in order.  */
+      uint64_t buf[GOMP_PERF_COUNTERS + 1];
+      uint64_t n, j = 0;
+      int k;
+
+      if (pt->fd[i] < 0 || (i > 0 && gomp_perf_events[i - 1].group
+				     == gomp_perf_events[i].group))
+	continue;
+      if (read (pt->fd[i], buf, sizeof (buf)) < (ssize_t) sizeof (buf[0]))
+	continue;
+      n = buf[0];
+      for (k = i; k < GOMP_PERF_COUNTERS
+		  && gomp_perf_events[k].group == gomp_perf_events[i].group;
+	   k++)
+	if (pt->fd[k] >= 0 && j < n)
+	  values[k] = buf[++j];
+    }
+  return pt->mask;
+}
+
+/* Close the counters of THR, when it exits.  */
+
+void
+gomp_perf_free_thread (struct gomp_thread *thr)
+{
+  struct gomp_perf_thread *pt = thr->perf;
+  int i;
+
+  if (pt == NULL)
+    return;
+  for (i = 0; i < GOMP_PERF_COUNTERS; i++)
+    if (pt->fd[i] >= 0)
+      close (pt->fd[i]);
+  free (pt);
+  thr->perf = NULL;
+}
@@ -31,8 +31,11 @@
 #include "libgomp.h"
 #include "proc.h"
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #ifdef HAVE_GETLOADAVG
 # ifdef HAVE_SYS_LOADAVG_H
 #  include <sys/loadavg.h>
@@ -73,12 +76,163 @@ gomp_cpuset_popcount (unsigned long cpusetsize, cpu_set_t *cpusetp)
 }
 #endif
 
+/* Directory of the cgroup of the process, below the mount point of its
+   cpu controller, which is the first gomp_cgroup_root_len characters.
+   NULL if the process is not in a cgroup with a cpu controller.  */
+static char *gomp_cgroup_dir;
+static size_t gomp_cgroup_root_len;
+/* True for cgroup v1, whose quota is in cpu.cfs_quota_us.  */
+static bool gomp_cgroup_v1;
+
+/* Find the cgroup of the process with a cpu controller in
+   /proc/self/cgroup.  Lines are hierarchy-ID:controllers:path, with
+   hierarchy 0 and no controllers for the cgroup v2 hierarchy.  */
+
+static void
+gomp_init_cgroup (void)
+{
+  FILE *f = fopen ("/proc/self/cgroup", "r");
+  char *line = NULL, *path = NULL;
+  size_t linelen = 0;
+  const char *root;
+
+  if (f == NULL)
+    return;
+  while (getline (&line, &linelen, f) > 0)
+    {
+      char *controllers = strchr (line, ':'), *p, *tok, *save;
+
+      if (controllers == NULL
+	  || (p = strchr (++controllers, ':')) == NULL)
+	continue;
+      *p++ = '\0';
+      p[strcspn (p, "\n")] = '\0';
+      if (*controllers == '\0' && line[0] == '0' && line[1] == ':')
+	{
+	  /* A cgroup v1 cpu controller takes precedence.  */
+	  if (path == NULL)
+	    path = strdup (p);
+	  continue;
+	}
+      for (tok = strtok_r (controllers, ",", &save); tok;
+	   tok = strtok_r (NULL, ",", &save))
+	if (strcmp (tok, "cpu") == 0)
+	  break;
+      if (tok != NULL)
+	{
+	  free (path);
+	  path = strdup (p);
+	  gomp_cgroup_v1 = true;
+	  break;
+	}
+    }
+  free (line);
+  fclose (f);
+  if (path == NULL)
+    return;
+
+  /* Without a cgroup namespace, PATH is relative to the root of the
+     hierarchy, which is mounted here; directories missing below the
+     mount point are skipped by gomp_cgroup_cpu_quota.  */
+  root = gomp_cgroup_v1 ? "/sys/fs/cgroup/cpu" : "/sys/fs/cgroup";
+  gomp_cgroup_root_len = strlen (root);
+  gomp_cgroup_dir = gomp_malloc (gomp_cgroup_root_len + strlen (path) + 1);
+  strcpy (gomp_cgroup_dir, root);
+  strcpy (gomp_cgroup_dir + gomp_cgroup_root_len,
+	  strcmp (path, "/") == 0 ? "" : path);
+  free (path);
+}
+
+/* Return the number of CPUs the quota of the cgroup of the process and
+   its ancestors allows it to use, rounded up, or 0 if there is no
+   quota.  The quota can change at any time, so it is read again on each
+   call.  */
+
+static unsigned long
+gomp_cgroup_cpu_quota (void)
+{
+  size_t len;
+  char *name;
+  unsigned long ret = 0;
+
+  if (gomp_cgroup_dir == NULL)
+    return 0;
+  len = strlen (gomp_cgroup_dir);
+  name = gomp_alloca (len + sizeof ("/cpu.cfs_period_us"));
+  memcpy (name, gomp_cgroup_dir, len);
+  while (1)
+    {
+      long long quota = -1, period = 0;
+      FILE *f;
+
+      if (gomp_cgroup_v1)
+	{
+	  strcpy (name + len, "/cpu.cfs_quota_us");
+	  f = fopen (name, "r");
+	  if (f != NULL)
+	    {
+	      if (fscanf (f, "%lld", &quota) != 1)
+		quota = -1;
+	      fclose (f);
+	      strcpy (name + len, "/cpu.cfs_period_us");
+	      f = fopen (name, "r");
+	    }
+	  if (f != NULL)
+	    {
+	      if (fscanf (f, "%lld", &period) != 1)
+		period = 0;
+	      fclose (f);
+	    }
+	}
+      else
+	{
+	  /* cpu.max is "max PERIOD" or "QUOTA PERIOD".  */
+	  strcpy (name + len, "/cpu.max");
+	  f = fopen (name, "r");
+	  if (f != NULL)
+	    {
+	      if (fscanf (f, "%lld %lld", &quota, &period) != 2)
+		quota = -1;
+	      fclose (f);
+	    }
+	}
+      if (quota > 0 && period > 0)
+	{
+	  unsigned long n = (quota + period - 1) / period;
+	  if (ret == 0 || n < ret)
+	    ret = n;
+	}
+      if (len <= gomp_cgroup_root_len)
+	break;
+      while (len > gomp_cgroup_root_len && name[len - 1] != '/')
+	len--;
+      len--;
+    }
+  return ret;
+}
+
+/* Cap *NPROCS at the cgroup CPU quota.  */
+
+static void
+gomp_apply_cpu_quota (unsigned long *nprocs)
+{
+  if (gomp_cpu_quota_var)
+    {
+      unsigned long quota = gomp_cgroup_cpu_quota ();
+      if (quota != 0 && quota < *nprocs)
+	*nprocs = quota;
+    }
+}
+
 /* At startup, determine the default number of threads.  It would seem
-   this should be related to the number of cpus online.  */
+   this should be related to the number of cpus online, or to the CPU
+   quota of the cgroup of the process if that is lower.  */
 
 void
 gomp_init_num_threads (void)
 {
+  if (gomp_cpu_quota_var)
+    gomp_init_cgroup ();
 #ifdef HAVE_PTHREAD_AFFINITY_NP
 #if defined (_SC_NPROCESSORS_CONF) && defined (CPU_ALLOC_SIZE)
   gomp_cpuset_size = sysconf (_SC_NPROCESSORS_CONF);
@@ -107,6 +261,7 @@ gomp_init_num_threads (void)
 	      break;
 	  gomp_cpuset_size = CPU_ALLOC_SIZE (i);
 #endif
+	  gomp_apply_cpu_quota (&gomp_global_icv.nthreads_var);
 	  return;
 	}
       if (ret != EINVAL)
@@ -141,10 +296,11 @@ gomp_init_num_threads (void)
 #ifdef _SC_NPROCESSORS_ONLN
   gomp_global_icv.nthreads_var = sysconf (_SC_NPROCESSORS_ONLN);
 #endif
+  gomp_apply_cpu_quota (&gomp_global_icv.nthreads_var);
 }
 
 static int
-get_num_procs (void)
+get_num_cpus (void)
 {
 #ifdef HAVE_PTHREAD_AFFINITY_NP
   if (gomp_places_list == NULL)
@@ -176,6 +332,18 @@ get_num_procs (void)
 #endif
 }
 
+/* Return the number of processors the process can use, taking the
+   cgroup CPU quota into account.  */
+
+static int
+get_num_procs (void)
+{
+  unsigned long n = get_num_cpus ();
+
+  gomp_apply_cpu_quota (&n);
+  return n;
+}
+
 /* When OMP_DYNAMIC is set, at thread launch determine the number of
    threads we should spawn for this team.  */
 /* ??? I have no idea what best practice for this is.  Surely some
@@ -210,9 +378,37 @@ gomp_dynamic_max_threads (void)
     return n_onln - loadavg;
 }
 
+/* Give the pages of the stack of the calling thread below the current
+   frame back to the system, keeping a margin for the frames of the
+   calls made from here.  It must not be called by the initial thread,
+   whose stack can grow.  */
+
+void
+gomp_release_stack (void)
+{
+  uintptr_t page = sysconf (_SC_PAGESIZE);
+  pthread_attr_t attr;
+  uintptr_t low, high;
+  void *addr;
+  size_t size;
+
+  if (pthread_getattr_np (pthread_self (), &attr) != 0)
+    return;
+  if (pthread_attr_getstack (&attr, &addr, &size) == 0)
+    {
+      low = ((uintptr_t) addr + page - 1) & ~(page - 1);
+      high = ((uintptr_t) __builtin_frame_address (0) - 4 * page)
+	     & ~(page - 1);
+      if (high > low)
+	madvise ((void *) low, high - low, MADV_DONTNEED);
+    }
+  pthread_attr_destroy (&attr);
+}
+
 int
 omp_get_num_procs (void)
 {
+  gomp_init_lazy ();
   return get_num_procs ();
 }
 
@@ -0,0 +1,248 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a Linux specific implementation of the machine topology.  It
+   is read from sysfs, below gomp_topology_root_var, the first time it is
+   needed.  */
+
+#include "libgomp.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct gomp_topology *gomp_topology_data;
+static gomp_mutex_t gomp_topology_lock;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_topology (void)
+{
+  gomp_mutex_init (&gomp_topology_lock);
+}
+#endif
+
+/* Read the first line of the file at PATH, relative to the topology
+   root, into BUF of SIZE bytes.  Return false if it can't be read.  */
+
+static bool
+gomp_topology_read (char *buf, size_t size, const char *path)
+{
+  size_t root_len = strlen (gomp_topology_root_var);
+  char *name = gomp_alloca (root_len + strlen (path) + 2);
+  FILE *f;
+  bool ret;
+
+  memcpy (name, gomp_topology_root_var, root_len);
+  name[root_len] = '/';
+  strcpy (name + root_len + 1, path);
+  f = fopen (name, "r");
+  if (f == NULL)
+    return false;
+  ret = fgets (buf, size, f) != NULL;
+  fclose (f);
+  return ret;
+}
+
+/* Return the number in the file at PATH, e.g. the first CPU of a CPU
+   list, or -1 if there is none.  */
+
+static long
+gomp_topology_read_number (const char *path)
+{
+  char buf[64], *end;
+  long ret;
+
+  if (!gomp_topology_read (buf, sizeof (buf), path))
+    return -1;
+  ret = strtol (buf, &end, 10);
+  return end == buf ? -1 : ret;
+}
+
+/* Return the first CPU sharing the unified or data cache of LEVEL with
+   CPU, or -1 if CPU has no such cache.  */
+
+static long
+gomp_topology_cache (unsigned int cpu, long level)
+{
+  char path[sizeof ("cpu/cpu/cache/index/shared_cpu_list")
+	    + 6 * sizeof (unsigned int)];
+  char type[32];
+  unsigned int index;
+
+  for (index = 0; ; index++)
+    {
+      long l;
+
+      sprintf (path, "cpu/cpu%u/cache/index%u/level", cpu, index);
+      l = gomp_topology_read_number (path);
+      if (l < 0)
+	return -1;
+      if (l != level)
+	continue;
+      sprintf (path, "cpu/cpu%u/cache/index%u/type", cpu, index);
+      if (gomp_topology_read (type, sizeof (type), path)
+	  && strncmp (type, "Instruction", 11) == 0)
+	continue;
+      sprintf (path, "cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+      return gomp_topology_read_number (path);
+    }
+}
+
+/* Return the NUMA node of CPU, given by a nodeN entry in its directory,
+   or -1 if it is unknown.  */
+
+static long
+gomp_topology_node (unsigned int cpu)
+{
+  size_t root_len = strlen (gomp_topology_root_var);
+  char *name = gomp_alloca (root_len + sizeof ("/cpu/cpu")
+			    + 3 * sizeof (unsigned int));
+  struct dirent *ent;
+  DIR *dir;
+  long node = -1;
+
+  sprintf (name, "%s/cpu/cpu%u", gomp_topology_root_var, cpu);
+  dir = opendir (name);
+  if (dir == NULL)
+    return -1;
+  while ((ent = readdir (dir)) != NULL)
+    if (strncmp (ent->d_name, "node", 4) == 0
+	&& ent->d_name[4] >= '0' && ent->d_name[4] <= '9')
+      {
+	node = atol (ent->d_name + 4);
+	break;
+      }
+  closedir (dir);
+  return node;
+}
+
+static struct gomp_topology *
+gomp_topology_init (void)
+{
+  struct gomp_topology *topo = gomp_malloc (sizeof (*topo));
+  char buf[256], path[sizeof ("cpu/cpu/topology/thread_siblings_list")
+		      + 3 * sizeof (unsigned int)];
+  long *keys, max_key, *map;
+  unsigned int cpu, level, ncpus = 0;
+  char *p;
+
+  /* cpu/possible is a list like 0-63; the last number is the highest
+     CPU.  */
+  if (gomp_topology_read (buf, sizeof (buf), "cpu/possible"))
+    {
+      for (p = buf; *p; )
+	if (*p >= '0' && *p <= '9')
+	  {
+	    unsigned long n = strtoul (p, &p, 10);
+	    if (n + 1 > ncpus)
+	      ncpus = n + 1;
+	  }
+	else
+	  p++;
+    }
+  if (ncpus == 0)
+    ncpus = gomp_available_cpus;
+
+  topo->ncpus = ncpus;
+  keys = gomp_malloc (GOMP_TOPOLOGY_LEVELS * ncpus * sizeof (long));
+  for (cpu = 0; cpu < ncpus; cpu++)
+    {
+      long *key = keys + cpu;
+
+      /* A domain is identified by its first CPU, or by the node or
+	 package number.  Where the information is missing, the CPU gets
+	 a core of its own and a cache or NUMA node shared like the level
+	 below, and all CPUs share one NUMA node and socket.  */
+      sprintf (path, "cpu/cpu%u/topology/thread_siblings_list", cpu);
+      key[GOMP_TOPOLOGY_CORE * ncpus] = gomp_topology_read_number (path);
+      if (key[GOMP_TOPOLOGY_CORE * ncpus] < 0)
+	key[GOMP_TOPOLOGY_CORE * ncpus] = cpu;
+      key[GOMP_TOPOLOGY_L2 * ncpus] = gomp_topology_cache (cpu, 2);
+      if (key[GOMP_TOPOLOGY_L2 * ncpus] < 0)
+	key[GOMP_TOPOLOGY_L2 * ncpus] = key[GOMP_TOPOLOGY_CORE * ncpus];
+      key[GOMP_TOPOLOGY_L3 * ncpus] = gomp_topology_cache (cpu, 3);
+      if (key[GOMP_TOPOLOGY_L3 * ncpus] < 0)
+	key[GOMP_TOPOLOGY_L3 * ncpus] = key[GOMP_TOPOLOGY_L2 * ncpus];
+      key[GOMP_TOPOLOGY_NUMA * ncpus] = gomp_topology_node (cpu);
+      if (key[GOMP_TOPOLOGY_NUMA * ncpus] < 0)
+	key[GOMP_TOPOLOGY_NUMA * ncpus] = 0;
+      sprintf (path, "cpu/cpu%u/topology/physical_package_id", cpu);
+      key[GOMP_TOPOLOGY_SOCKET * ncpus] = gomp_topology_read_number (path);
+      if (key[GOMP_TOPOLOGY_SOCKET * ncpus] < 0)
+	key[GOMP_TOPOLOGY_SOCKET * ncpus] = 0;
+    }
+
+  /* Number the domains of each level densely, in the order of their
+     first CPU.  */
+  topo->ids = gomp_malloc (GOMP_TOPOLOGY_LEVELS * ncpus * sizeof (int));
+  for (level = 0; level < GOMP_TOPOLOGY_LEVELS; level++)
+    {
+      long *key = keys + level * ncpus;
+
+      max_key = 0;
+      for (cpu = 0; cpu < ncpus; cpu++)
+	if (key[cpu] > max_key)
+	  max_key = key[cpu];
+      map = gomp_malloc ((max_key + 1) * sizeof (long));
+      memset (map, -1, (max_key + 1) * sizeof (long));
+      topo->ndomains[level] = 0;
+      for (cpu = 0; cpu < ncpus; cpu++)
+	{
+	  if (map[key[cpu]] < 0)
+	    map[key[cpu]] = topo->ndomains[level]++;
+	  topo->ids[level * ncpus + cpu] = map[key[cpu]];
+	}
+      free (map);
+    }
+
+  topo->numa_node = gomp_malloc (topo->ndomains[GOMP_TOPOLOGY_NUMA]
+				 * sizeof (int));
+  for (cpu = 0; cpu < ncpus; cpu++)
+    topo->numa_node[topo->ids[GOMP_TOPOLOGY_NUMA * ncpus + cpu]]
+      = keys[GOMP_TOPOLOGY_NUMA * ncpus + cpu];
+  free (keys);
+  return topo;
+}
+
+/* Return the topology of the machine, reading it on the first call.  */
+
+const struct gomp_topology *
+gomp_get_topology (void)
+{
+  struct gomp_topology *topo
+    = __atomic_load_n (&gomp_topology_data, MEMMODEL_ACQUIRE);
+
+  if (topo == NULL)
+    {
+      gomp_mutex_lock (&gomp_topology_lock);
+      topo = gomp_topology_data;
+      if (topo == NULL)
+	{
+	  topo = gomp_topology_init ();
+	  __atomic_store_n (&gomp_topology_data, topo, MEMMODEL_RELEASE);
+	}
+      gomp_mutex_unlock (&gomp_topology_lock);
+    }
+  return topo;
+}
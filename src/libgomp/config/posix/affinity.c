@@ -31,6 +31,11 @@ gomp_init_affinity (void)
 {
 }
 
+void
+gomp_init_master_affinity (void)
+{
+}
+
 void
 gomp_init_thread_affinity (pthread_attr_t *attr, unsigned int place)
 {
@@ -113,3 +118,30 @@ gomp_affinity_print_place (void *p)
 {
   (void) p;
 }
+
+int
+gomp_affinity_place_of_address (const void *addr)
+{
+  (void) addr;
+  return -1;
+}
+
+bool
+gomp_affinity_multinode_p (void)
+{
+  return false;
+}
+
+int
+gomp_affinity_place_node (unsigned long place)
+{
+  (void) place;
+  return -1;
+}
+
+void
+gomp_affinity_move_local (void *addr, size_t size)
+{
+  (void) addr;
+  (void) size;
+}
@@ -109,8 +109,9 @@ gomp_barrier_wait (gomp_barrier_t *barrier)
   gomp_barrier_wait_end (barrier, gomp_barrier_wait_start (barrier));
 }
 
-void
-gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
+static void
+gomp_team_barrier_wait_end_1 (gomp_barrier_t *bar,
+			      gomp_barrier_state_t state)
 {
   unsigned int n;
 
@@ -170,9 +171,9 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
     }
 }
 
-bool
-gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
-				   gomp_barrier_state_t state)
+static bool
+gomp_team_barrier_wait_cancel_end_1 (gomp_barrier_t *bar,
+				     gomp_barrier_state_t state)
 {
   unsigned int n;
 
@@ -245,6 +246,32 @@ gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
   return false;
 }
 
+/* The team barrier waits are reported to the tool, if any.  */
+
+void
+gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
+{
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_begin (bar);
+  gomp_team_barrier_wait_end_1 (bar, state);
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_end (bar);
+}
+
+bool
+gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
+				   gomp_barrier_state_t state)
+{
+  bool ret;
+
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_begin (bar);
+  ret = gomp_team_barrier_wait_cancel_end_1 (bar, state);
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_barrier_wait_end (bar);
+  return ret;
+}
+
 void
 gomp_team_barrier_wait (gomp_barrier_t *barrier)
 {
@@ -0,0 +1,46 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a generic stub implementation of the thread budget shared by
+   the processes on a node; GOMP_NODE_BUDGET is ignored.  */
+
+#include "libgomp.h"
+
+unsigned long *gomp_node_active;
+
+void
+gomp_init_node_budget (void)
+{
+}
+
+unsigned
+gomp_node_budget_acquire (unsigned nthreads,
+			  bool resize __attribute__((unused)))
+{
+  return nthreads;
+}
+
+void
+gomp_node_budget_release (unsigned nthreads __attribute__((unused)))
+{
+}
@@ -51,19 +51,34 @@ gomp_destroy_lock_30 (omp_lock_t *lock)
 void
 gomp_set_lock_30 (omp_lock_t *lock)
 {
-  pthread_mutex_lock (lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
+  if (!gomp_tool_mutex_trylock (lock))
+    pthread_mutex_lock (lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
 gomp_unset_lock_30 (omp_lock_t *lock)
 {
+  gomp_tool_event (gomp_tool_event_lock_release, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
   pthread_mutex_unlock (lock);
 }
 
 int
 gomp_test_lock_30 (omp_lock_t *lock)
 {
-  return pthread_mutex_trylock (lock) == 0;
+  if (pthread_mutex_trylock (lock) != 0)
+    return 0;
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_lock_tested (lock, gomp_tool_mutex_lock,
+			   (unsigned long) __builtin_return_address (0));
+  return 1;
 }
 
 void
@@ -87,7 +102,14 @@ gomp_set_nest_lock_30 (omp_nest_lock_t *lock)
 
   if (lock->owner != me)
     {
-      pthread_mutex_lock (&lock->lock);
+      gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
+      if (!gomp_tool_mutex_trylock (&lock->lock))
+	pthread_mutex_lock (&lock->lock);
+      gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
     }
   lock->count++;
@@ -98,6 +120,9 @@ gomp_unset_nest_lock_30 (omp_nest_lock_t *lock)
 {
   if (--lock->count == 0)
     {
+      gomp_tool_event (gomp_tool_event_lock_release, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = NULL;
       pthread_mutex_unlock (&lock->lock);
     }
@@ -112,6 +137,9 @@ gomp_test_nest_lock_30 (omp_nest_lock_t *lock)
     {
       if (pthread_mutex_trylock (&lock->lock) != 0)
 	return 0;
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	gomp_tool_lock_tested (lock, gomp_tool_mutex_nest_lock,
+			       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
     }
 
@@ -135,20 +163,36 @@ gomp_destroy_lock_30 (omp_lock_t *lock)
 void
 gomp_set_lock_30 (omp_lock_t *lock)
 {
-  while (sem_wait (lock) != 0)
-    ;
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
+  if (!(__builtin_expect (gomp_tool_enabled, 0)
+	&& gomp_tool_lock_tried (sem_trywait (lock) == 0)))
+    while (sem_wait (lock) != 0)
+      ;
+  gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
 gomp_unset_lock_30 (omp_lock_t *lock)
 {
+  gomp_tool_event (gomp_tool_event_lock_release, lock,
+		   gomp_tool_mutex_lock,
+		   (unsigned long) __builtin_return_address (0));
   sem_post (lock);
 }
 
 int
 gomp_test_lock_30 (omp_lock_t *lock)
 {
-  return sem_trywait (lock) == 0;
+  if (sem_trywait (lock) != 0)
+    return 0;
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_lock_tested (lock, gomp_tool_mutex_lock,
+			   (unsigned long) __builtin_return_address (0));
+  return 1;
 }
 
 void
@@ -172,8 +216,16 @@ gomp_set_nest_lock_30 (omp_nest_lock_t *lock)
 
   if (lock->owner != me)
     {
-      while (sem_wait (&lock->lock) != 0)
-	;
+      gomp_tool_event (gomp_tool_event_lock_wait_begin, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
+      if (!(__builtin_expect (gomp_tool_enabled, 0)
+	    && gomp_tool_lock_tried (sem_trywait (&lock->lock) == 0)))
+	while (sem_wait (&lock->lock) != 0)
+	  ;
+      gomp_tool_event (gomp_tool_event_lock_wait_end, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
     }
   lock->count++;
@@ -184,6 +236,9 @@ gomp_unset_nest_lock_30 (omp_nest_lock_t *lock)
 {
   if (--lock->count == 0)
     {
+      gomp_tool_event (gomp_tool_event_lock_release, lock,
+		       gomp_tool_mutex_nest_lock,
+		       (unsigned long) __builtin_return_address (0));
       lock->owner = NULL;
       sem_post (&lock->lock);
     }
@@ -198,6 +253,9 @@ gomp_test_nest_lock_30 (omp_nest_lock_t *lock)
     {
       if (sem_trywait (&lock->lock) != 0)
 	return 0;
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	gomp_tool_lock_tested (lock, gomp_tool_mutex_nest_lock,
+			       (unsigned long) __builtin_return_address (0));
       lock->owner = me;
     }
 
@@ -44,6 +44,11 @@ static inline void gomp_mutex_lock (gomp_mutex_t *mutex)
   pthread_mutex_lock (mutex);
 }
 
+static inline bool gomp_mutex_trylock (gomp_mutex_t *mutex)
+{
+  return pthread_mutex_trylock (mutex) == 0;
+}
+
 static inline void gomp_mutex_unlock (gomp_mutex_t *mutex)
 {
    pthread_mutex_unlock (mutex);
@@ -88,6 +88,13 @@ gomp_dynamic_max_threads (void)
     return n_onln - loadavg;
 }
 
+/* Releasing the unused pages of the stack is not supported.  */
+
+void
+gomp_release_stack (void)
+{
+}
+
 int
 omp_get_num_procs (void)
 {
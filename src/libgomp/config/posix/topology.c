@@ -0,0 +1,83 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a generic implementation of the machine topology, which
+   treats every CPU as a core of its own on a single NUMA node and
+   socket.  */
+
+#include "libgomp.h"
+
+static struct gomp_topology *gomp_topology_data;
+static gomp_mutex_t gomp_topology_lock;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_topology (void)
+{
+  gomp_mutex_init (&gomp_topology_lock);
+}
+#endif
+
+static struct gomp_topology *
+gomp_topology_init (void)
+{
+  struct gomp_topology *topo = gomp_malloc (sizeof (*topo));
+  unsigned int cpu, level, ncpus = gomp_available_cpus;
+
+  if (ncpus == 0)
+    ncpus = 1;
+  topo->ncpus = ncpus;
+  topo->ids = gomp_malloc (GOMP_TOPOLOGY_LEVELS * ncpus * sizeof (int));
+  for (level = 0; level < GOMP_TOPOLOGY_LEVELS; level++)
+    {
+      bool flat = level >= GOMP_TOPOLOGY_NUMA;
+
+      topo->ndomains[level] = flat ? 1 : ncpus;
+      for (cpu = 0; cpu < ncpus; cpu++)
+	topo->ids[level * ncpus + cpu] = flat ? 0 : cpu;
+    }
+  topo->numa_node = gomp_malloc_cleared (sizeof (int));
+  return topo;
+}
+
+/* Return the topology of the machine, building it on the first call.  */
+
+const struct gomp_topology *
+gomp_get_topology (void)
+{
+  struct gomp_topology *topo
+    = __atomic_load_n (&gomp_topology_data, MEMMODEL_ACQUIRE);
+
+  if (topo == NULL)
+    {
+      gomp_mutex_lock (&gomp_topology_lock);
+      topo = gomp_topology_data;
+      if (topo == NULL)
+	{
+	  topo = gomp_topology_init ();
+	  __atomic_store_n (&gomp_topology_data, topo, MEMMODEL_RELEASE);
+	}
+      gomp_mutex_unlock (&gomp_topology_lock);
+    }
+  return topo;
+}
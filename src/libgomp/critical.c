@@ -30,17 +30,30 @@
 
 static gomp_mutex_t default_lock;
 
+/* The lock of unnamed critical constructs, for the profile to name it.  */
+const void *const gomp_critical_default_lock = &default_lock;
+
 void
 GOMP_critical_start (void)
 {
   /* There is an implicit flush on entry to a critical region. */
   __atomic_thread_fence (MEMMODEL_RELEASE);
-  gomp_mutex_lock (&default_lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, &default_lock,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
+  if (!gomp_tool_mutex_trylock (&default_lock))
+    gomp_mutex_lock (&default_lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_end, &default_lock,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
 GOMP_critical_end (void)
 {
+  gomp_tool_event (gomp_tool_event_lock_release, &default_lock,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
   gomp_mutex_unlock (&default_lock);
 }
 
@@ -94,7 +107,16 @@ GOMP_critical_name_start (void **pptr)
 	}
     }
 
-  gomp_mutex_lock (plock);
+  /* The tool identifies the construct by its name, where the compiler
+     put it.  */
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, pptr,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
+  if (!gomp_tool_mutex_trylock (plock))
+    gomp_mutex_lock (plock);
+  gomp_tool_event (gomp_tool_event_lock_wait_end, pptr,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
@@ -111,6 +133,9 @@ GOMP_critical_name_end (void **pptr)
   else
     plock = *pptr;
 
+  gomp_tool_event (gomp_tool_event_lock_release, pptr,
+		   gomp_tool_mutex_critical,
+		   (unsigned long) __builtin_return_address (0));
   gomp_mutex_unlock (plock);
 }
 
@@ -126,12 +151,22 @@ static gomp_mutex_t atomic_lock;
 void
 GOMP_atomic_start (void)
 {
-  gomp_mutex_lock (&atomic_lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_begin, &atomic_lock,
+		   gomp_tool_mutex_atomic,
+		   (unsigned long) __builtin_return_address (0));
+  if (!gomp_tool_mutex_trylock (&atomic_lock))
+    gomp_mutex_lock (&atomic_lock);
+  gomp_tool_event (gomp_tool_event_lock_wait_end, &atomic_lock,
+		   gomp_tool_mutex_atomic,
+		   (unsigned long) __builtin_return_address (0));
 }
 
 void
 GOMP_atomic_end (void)
 {
+  gomp_tool_event (gomp_tool_event_lock_release, &atomic_lock,
+		   gomp_tool_mutex_atomic,
+		   (unsigned long) __builtin_return_address (0));
   gomp_mutex_unlock (&atomic_lock);
 }
 
@@ -65,13 +65,35 @@ struct gomp_task_icv gomp_global_icv = {
 };
 
 unsigned long gomp_max_active_levels_var = INT_MAX;
+int gomp_max_task_priority_var = 0;
 bool gomp_cancel_var = false;
 bool gomp_binlpt_debug_var = false;
 #ifndef HAVE_SYNC_BUILTINS
 gomp_mutex_t gomp_managed_threads_lock;
 #endif
 unsigned long gomp_available_cpus = 1, gomp_managed_threads = 1;
+bool gomp_initialized;
 unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+unsigned long gomp_task_successor_depth_var = 16;
+bool gomp_task_cutoff_adaptive_var;
+unsigned long gomp_task_cutoff_depth_var = 8;
+unsigned long gomp_task_cutoff_queue_var = 4;
+unsigned long gomp_task_cutoff_ns_var = 2000;
+unsigned long gomp_task_stacksize_var;
+bool gomp_numa_local_var = true;
+bool gomp_cpu_quota_var = true;
+bool gomp_adaptive_teams_var;
+unsigned long gomp_node_budget_var;
+unsigned long gomp_shared_pool_var;
+unsigned long gomp_prespawn_var;
+char *gomp_topology_root_var = "/sys/devices/system";
+char *gomp_tool_var;
+char *gomp_profile_var;
+bool gomp_profile_counters_var;
+bool gomp_profile_locks_var;
+char *gomp_trace_var;
+unsigned long gomp_trace_buffer_var = 65536;
+unsigned long gomp_trace_sampling_var = 1;
 unsigned long *gomp_nthreads_var_list, gomp_nthreads_var_list_len;
 char *gomp_bind_var_list;
 unsigned long gomp_bind_var_list_len;
@@ -204,6 +226,74 @@ parse_unsigned_long (const char *name, unsigned long *pvalue, bool allow_zero)
   return false;
 }
 
+/* Parse the GOMP_TASK_CUTOFF environment variable.  The syntax is
+   either "fixed" or "adaptive[,DEPTH[,QUEUE[,NS]]]".  */
+
+static void
+parse_task_cutoff (void)
+{
+  unsigned long *fields[3] = { &gomp_task_cutoff_depth_var,
+			       &gomp_task_cutoff_queue_var,
+			       &gomp_task_cutoff_ns_var };
+  unsigned long values[3];
+  char *env, *end;
+  int i;
+
+  env = getenv ("GOMP_TASK_CUTOFF");
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (strncasecmp (env, "fixed", 5) == 0)
+    {
+      env += 5;
+      while (isspace ((unsigned char) *env))
+	++env;
+      if (*env != '\0')
+	goto unknown;
+      gomp_task_cutoff_adaptive_var = false;
+      return;
+    }
+  if (strncasecmp (env, "adaptive", 8) != 0)
+    goto unknown;
+  env += 8;
+
+  for (i = 0; i < 3; i++)
+    values[i] = *fields[i];
+  for (i = 0; ; i++)
+    {
+      while (isspace ((unsigned char) *env))
+	++env;
+      if (*env == '\0')
+	break;
+      if (*env++ != ',' || i == 3)
+	goto invalid;
+      while (isspace ((unsigned char) *env))
+	++env;
+      if (*env == '\0')
+	goto invalid;
+
+      errno = 0;
+      values[i] = strtoul (env, &end, 10);
+      if (errno || *env == '-' || end == env)
+	goto invalid;
+      env = end;
+    }
+
+  gomp_task_cutoff_adaptive_var = true;
+  for (i = 0; i < 3; i++)
+    *fields[i] = values[i];
+  return;
+
+ unknown:
+  gomp_error ("Unknown value for environment variable GOMP_TASK_CUTOFF");
+  return;
+
+ invalid:
+  gomp_error ("Invalid value for environment variable GOMP_TASK_CUTOFF");
+}
+
 /* Parse a positive int environment variable.  Return true if one was
    present and it was successfully parsed.  */
 
@@ -588,6 +678,16 @@ parse_places_var (const char *name, bool ignore)
       env += 7;
       level = 3;
     }
+  else if (strncasecmp (env, "ll_caches", 9) == 0)
+    {
+      env += 9;
+      level = 4;
+    }
+  else if (strncasecmp (env, "numa_domains", 12) == 0)
+    {
+      env += 12;
+      level = 5;
+    }
   if (level)
     {
       count = ULONG_MAX;
@@ -887,6 +987,32 @@ parse_boolean (const char *name, bool *value)
     gomp_error ("Invalid value for environment variable %s", name);
 }
 
+/* Parse an environment variable NAME that is either a boolean or a
+   positive count and store the count to *PVALUE.  TRUE stands for a
+   default count chosen by the caller, represented as ULONG_MAX, and
+   FALSE for 0.  */
+
+static void
+parse_boolean_or_count (const char *name, unsigned long *pvalue)
+{
+  const char *env;
+  bool enabled = false;
+
+  env = getenv (name);
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (*env >= '0' && *env <= '9')
+    parse_unsigned_long (name, pvalue, false);
+  else
+    {
+      parse_boolean (name, &enabled);
+      *pvalue = enabled ? ULONG_MAX : 0;
+    }
+}
+
 /* Parse the OMP_WAIT_POLICY environment variable and store the
    result in gomp_active_wait_policy.  */
 
@@ -1159,6 +1285,8 @@ handle_omp_display_env (unsigned long stacksize, int wait_policy)
 	   gomp_cancel_var ? "TRUE" : "FALSE");
   fprintf (stderr, "  OMP_DEFAULT_DEVICE = '%d'\n",
 	   gomp_global_icv.default_device_var);
+  fprintf (stderr, "  OMP_MAX_TASK_PRIORITY = '%d'\n",
+	   gomp_max_task_priority_var);
 
   if (verbose)
     {
@@ -1171,45 +1299,80 @@ handle_omp_display_env (unsigned long stacksize, int wait_policy)
       fprintf (stderr, "  GOMP_SPINCOUNT = '%lu'\n",
 	       (unsigned long) gomp_spin_count_var);
 #endif
+      fprintf (stderr, "  GOMP_TASK_SUCCESSOR_DEPTH = '%lu'\n",
+	       gomp_task_successor_depth_var);
+      if (gomp_task_cutoff_adaptive_var)
+	fprintf (stderr, "  GOMP_TASK_CUTOFF = 'ADAPTIVE,%lu,%lu,%lu'\n",
+		 gomp_task_cutoff_depth_var, gomp_task_cutoff_queue_var,
+		 gomp_task_cutoff_ns_var);
+      else
+	fputs ("  GOMP_TASK_CUTOFF = 'FIXED'\n", stderr);
+      fprintf (stderr, "  GOMP_TASK_STACKSIZE = '%lu'\n",
+	       gomp_task_stacksize_var);
+      fprintf (stderr, "  GOMP_NUMA_LOCAL = '%s'\n",
+	       gomp_numa_local_var ? "TRUE" : "FALSE");
+      fprintf (stderr, "  GOMP_TOPOLOGY_ROOT = '%s'\n",
+	       gomp_topology_root_var);
+      fprintf (stderr, "  GOMP_CPU_QUOTA = '%s'\n",
+	       gomp_cpu_quota_var ? "TRUE" : "FALSE");
+      fprintf (stderr, "  GOMP_ADAPTIVE_TEAMS = '%s'\n",
+	       gomp_adaptive_teams_var ? "TRUE" : "FALSE");
+      if (gomp_node_active != NULL)
+	fprintf (stderr, "  GOMP_NODE_BUDGET = '%lu'\n", gomp_node_budget_var);
+      else
+	fputs ("  GOMP_NODE_BUDGET = 'FALSE'\n", stderr);
+      if (gomp_shared_pool_var != 0)
+	fprintf (stderr, "  GOMP_SHARED_POOL = '%lu'\n", gomp_shared_pool_var);
+      else
+	fputs ("  GOMP_SHARED_POOL = 'FALSE'\n", stderr);
+      if (gomp_prespawn_var == ULONG_MAX)
+	fputs ("  GOMP_PRESPAWN = 'TRUE'\n", stderr);
+      else if (gomp_prespawn_var != 0)
+	fprintf (stderr, "  GOMP_PRESPAWN = '%lu'\n", gomp_prespawn_var);
+      else
+	fputs ("  GOMP_PRESPAWN = 'FALSE'\n", stderr);
+      fprintf (stderr, "  GOMP_TOOL = '%s'\n",
+	       gomp_tool_var ? gomp_tool_var : "");
+      fprintf (stderr, "  GOMP_PROFILE = '%s'\n",
+	       gomp_profile_var ? gomp_profile_var : "FALSE");
+      fprintf (stderr, "  GOMP_PROFILE_COUNTERS = '%s'\n",
+	       gomp_profile_counters_var ? "TRUE" : "FALSE");
+      fprintf (stderr, "  GOMP_PROFILE_LOCKS = '%s'\n",
+	       gomp_profile_locks_var ? "TRUE" : "FALSE");
+      fprintf (stderr, "  GOMP_TRACE = '%s'\n",
+	       gomp_trace_var ? gomp_trace_var : "");
+      fprintf (stderr, "  GOMP_TRACE_BUFFER = '%lu'\n",
+	       gomp_trace_buffer_var);
+      fprintf (stderr, "  GOMP_TRACE_SAMPLING = '%lu'\n",
+	       gomp_trace_sampling_var);
     }
 
   fputs ("OPENMP DISPLAY ENVIRONMENT END\n", stderr);
 }
 
 
-static void __attribute__((constructor))
-initialize_env (void)
-{
-  unsigned long thread_limit_var, stacksize;
-  int wait_policy;
+/* The part of the initialization that queries the system: the CPUs
+   available, which set the default of OMP_NUM_THREADS, and the places.
+   It is deferred until the runtime is first used, see gomp_init_lazy,
+   so that processes which never start a parallel region do not pay for
+   it.  It may run in any thread, so it only builds the places and binds
+   no thread.  */
 
-  /* Do a compile time check that mkomp_h.pl did good job.  */
-  omp_check_defines ();
+static void
+initialize_env_lazy (void)
+{
+  bool ignore = false;
 
-  parse_schedule ();
-  parse_boolean ("OMP_DYNAMIC", &gomp_global_icv.dyn_var);
-  parse_boolean ("OMP_NESTED", &gomp_global_icv.nest_var);
-  parse_boolean ("OMP_CANCELLATION", &gomp_cancel_var);
-  parse_boolean ("OMP_BINLPT_DEBUG", &gomp_binlpt_debug_var);
-  parse_int ("OMP_DEFAULT_DEVICE", &gomp_global_icv.default_device_var, true);
-  parse_unsigned_long ("OMP_MAX_ACTIVE_LEVELS", &gomp_max_active_levels_var,
-		       true);
-  if (parse_unsigned_long ("OMP_THREAD_LIMIT", &thread_limit_var, false))
-    {
-      gomp_global_icv.thread_limit_var
-	= thread_limit_var > INT_MAX ? UINT_MAX : thread_limit_var;
-    }
-#ifndef HAVE_SYNC_BUILTINS
-  gomp_mutex_init (&gomp_managed_threads_lock);
-#endif
   gomp_init_num_threads ();
   gomp_available_cpus = gomp_global_icv.nthreads_var;
+  if (gomp_shared_pool_var == ULONG_MAX)
+    gomp_shared_pool_var
+      = gomp_available_cpus > 1 ? gomp_available_cpus - 1 : 1;
   if (!parse_unsigned_long_list ("OMP_NUM_THREADS",
 				 &gomp_global_icv.nthreads_var,
 				 &gomp_nthreads_var_list,
 				 &gomp_nthreads_var_list_len))
     gomp_global_icv.nthreads_var = gomp_available_cpus;
-  bool ignore = false;
   if (parse_bind_var ("OMP_PROC_BIND",
 		      &gomp_global_icv.bind_var,
 		      &gomp_bind_var_list,
@@ -1238,6 +1401,75 @@ initialize_env (void)
     }
   if (gomp_global_icv.bind_var != omp_proc_bind_false)
     gomp_init_affinity ();
+  if (gomp_node_budget_var != 0)
+    gomp_init_node_budget ();
+
+  __atomic_store_n (&gomp_initialized, true, MEMMODEL_RELEASE);
+}
+
+void
+gomp_init_lazy_slow (void)
+{
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once (&once, initialize_env_lazy);
+}
+
+static void __attribute__((constructor))
+initialize_env (void)
+{
+  unsigned long thread_limit_var, stacksize;
+  int wait_policy;
+  char *env;
+
+  /* Do a compile time check that mkomp_h.pl did good job.  */
+  omp_check_defines ();
+
+  parse_schedule ();
+  parse_boolean ("OMP_DYNAMIC", &gomp_global_icv.dyn_var);
+  parse_boolean ("OMP_NESTED", &gomp_global_icv.nest_var);
+  parse_boolean ("OMP_CANCELLATION", &gomp_cancel_var);
+  parse_boolean ("OMP_BINLPT_DEBUG", &gomp_binlpt_debug_var);
+  parse_int ("OMP_DEFAULT_DEVICE", &gomp_global_icv.default_device_var, true);
+  parse_int ("OMP_MAX_TASK_PRIORITY", &gomp_max_task_priority_var, true);
+  parse_unsigned_long ("OMP_MAX_ACTIVE_LEVELS", &gomp_max_active_levels_var,
+		       true);
+  parse_unsigned_long ("GOMP_TASK_SUCCESSOR_DEPTH",
+		       &gomp_task_successor_depth_var, true);
+  parse_task_cutoff ();
+  parse_stacksize ("GOMP_TASK_STACKSIZE", &gomp_task_stacksize_var);
+  parse_boolean ("GOMP_NUMA_LOCAL", &gomp_numa_local_var);
+  env = getenv ("GOMP_TOPOLOGY_ROOT");
+  if (env != NULL && *env != '\0')
+    gomp_topology_root_var = env;
+  parse_boolean ("GOMP_CPU_QUOTA", &gomp_cpu_quota_var);
+  parse_boolean ("GOMP_ADAPTIVE_TEAMS", &gomp_adaptive_teams_var);
+  /* The number of CPUs online is used for TRUE.  */
+  parse_boolean_or_count ("GOMP_NODE_BUDGET", &gomp_node_budget_var);
+  parse_boolean_or_count ("GOMP_SHARED_POOL", &gomp_shared_pool_var);
+  /* The nthreads-var ICV is used for TRUE.  */
+  parse_boolean_or_count ("GOMP_PRESPAWN", &gomp_prespawn_var);
+  env = getenv ("GOMP_TOOL");
+  if (env != NULL && *env != '\0')
+    gomp_tool_var = env;
+  env = getenv ("GOMP_PROFILE");
+  if (env != NULL && *env != '\0' && strcasecmp (env, "false") != 0)
+    gomp_profile_var = env;
+  parse_boolean ("GOMP_PROFILE_COUNTERS", &gomp_profile_counters_var);
+  parse_boolean ("GOMP_PROFILE_LOCKS", &gomp_profile_locks_var);
+  env = getenv ("GOMP_TRACE");
+  if (env != NULL && *env != '\0')
+    gomp_trace_var = env;
+  parse_unsigned_long ("GOMP_TRACE_BUFFER", &gomp_trace_buffer_var, false);
+  parse_unsigned_long ("GOMP_TRACE_SAMPLING", &gomp_trace_sampling_var,
+		       false);
+  if (parse_unsigned_long ("OMP_THREAD_LIMIT", &thread_limit_var, false))
+    {
+      gomp_global_icv.thread_limit_var
+	= thread_limit_var > INT_MAX ? UINT_MAX : thread_limit_var;
+    }
+#ifndef HAVE_SYNC_BUILTINS
+  gomp_mutex_init (&gomp_managed_threads_lock);
+#endif
   wait_policy = parse_wait_policy ();
   if (!parse_spincount ("GOMP_SPINCOUNT", &gomp_spin_count_var))
     {
@@ -1288,7 +1520,34 @@ initialize_env (void)
 	gomp_error ("Stack size change failed: %s", strerror (err));
     }
 
+  /* Untied tasks get as much stack as the threads by default, so that
+     suspending them does not limit their recursion depth.  */
+  if (gomp_task_stacksize_var == 0)
+    {
+      size_t size;
+
+      if (pthread_attr_getstacksize (&gomp_thread_attr, &size) == 0)
+	gomp_task_stacksize_var = size;
+      else
+	gomp_task_stacksize_var = 2 * 1024 * 1024;
+    }
+
+  /* The tools and the profiler see all the events of the program.  */
+  if (gomp_profile_var != NULL)
+    gomp_init_profile ();
+  if (gomp_trace_var != NULL)
+    gomp_init_trace ();
+  if (gomp_tool_var != NULL)
+    gomp_init_tool ();
+
+  /* Displaying the environment requires all of it.  */
+  env = getenv ("OMP_DISPLAY_ENV");
+  if (env != NULL)
+    gomp_init_lazy ();
   handle_omp_display_env (stacksize, wait_policy);
+
+  if (gomp_prespawn_var != 0)
+    gomp_prespawn ();
 }
 
 
@@ -1438,6 +1697,12 @@ omp_get_team_num (void)
   return 0;
 }
 
+int
+omp_get_max_task_priority (void)
+{
+  return gomp_max_task_priority_var;
+}
+
 int
 omp_is_initial_device (void)
 {
@@ -1463,4 +1728,5 @@ ialias (omp_get_default_device)
 ialias (omp_get_num_devices)
 ialias (omp_get_num_teams)
 ialias (omp_get_team_num)
+ialias (omp_get_max_task_priority)
 ialias (omp_is_initial_device)
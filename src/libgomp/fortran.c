@@ -73,6 +73,8 @@ ialias_redirect (omp_get_num_devices)
 ialias_redirect (omp_get_num_teams)
 ialias_redirect (omp_get_team_num)
 ialias_redirect (omp_is_initial_device)
+ialias_redirect (omp_get_max_task_priority)
+ialias_redirect (omp_pause_resource)
 #endif
 
 #ifndef LIBGOMP_GNU_SYMBOL_VERSIONING
@@ -492,3 +494,123 @@ omp_is_initial_device_ (void)
 {
   return omp_is_initial_device ();
 }
+
+int32_t
+omp_get_max_task_priority_ (void)
+{
+  return omp_get_max_task_priority ();
+}
+
+int32_t
+omp_pause_resource_ (const int32_t *kind, const int32_t *device_num)
+{
+  return omp_pause_resource (*kind, *device_num);
+}
+
+int32_t
+omp_pause_resource_8_ (const int32_t *kind, const int64_t *device_num)
+{
+  return omp_pause_resource (*kind, TO_INT (*device_num));
+}
+
+int32_t
+omp_pause_resource_all_ (const int32_t *kind)
+{
+  return omp_pause_resource_all (*kind);
+}
+
+void
+omp_fulfill_event_ (const int64_t *event)
+{
+  omp_fulfill_event ((omp_event_handle_t) (uintptr_t) *event);
+}
+
+/* Wrappers of the GNU extensions.  */
+
+int64_t
+gomp_task_detach_ (void)
+{
+  return (uintptr_t) GOMP_task_detach ();
+}
+
+void
+gomp_set_task_cost_ (const int32_t *cost)
+{
+  GOMP_set_task_cost (*cost > 0 ? *cost : 0);
+}
+
+void
+gomp_set_task_cost_8_ (const int64_t *cost)
+{
+  GOMP_set_task_cost (*cost > 0 ? *cost : 0);
+}
+
+void
+gomp_set_task_affinity_ (const void *addr)
+{
+  GOMP_set_task_affinity (addr);
+}
+
+void
+gomp_set_task_place_ (const int32_t *place_num)
+{
+  GOMP_set_task_place (*place_num);
+}
+
+void
+gomp_set_task_place_8_ (const int64_t *place_num)
+{
+  GOMP_set_task_place (TO_INT (*place_num));
+}
+
+int32_t
+gomp_prewarm_ (const int32_t *nthreads)
+{
+  return GOMP_prewarm (*nthreads);
+}
+
+int32_t
+gomp_prewarm_8_ (const int64_t *nthreads)
+{
+  return GOMP_prewarm (TO_INT (*nthreads));
+}
+
+/* SUBROUTINE is called with a reference to DATA as its only argument.  */
+
+int64_t
+gomp_parallel_async_ (void (*subroutine) (void *), void *data,
+		      const int32_t *num_threads)
+{
+  return (uintptr_t) GOMP_parallel_async (subroutine, data, *num_threads);
+}
+
+int64_t
+gomp_parallel_async_8_ (void (*subroutine) (void *), void *data,
+			const int64_t *num_threads)
+{
+  return (uintptr_t) GOMP_parallel_async (subroutine, data,
+					  TO_INT (*num_threads));
+}
+
+void
+gomp_parallel_wait_ (const int64_t *handle)
+{
+  GOMP_parallel_wait ((gomp_parallel_handle_t) (uintptr_t) *handle);
+}
+
+int32_t
+gomp_parallel_test_ (const int64_t *handle)
+{
+  return GOMP_parallel_test ((gomp_parallel_handle_t) (uintptr_t) *handle);
+}
+
+int32_t
+gomp_get_perf_counter_ (const int32_t *counter, int64_t *value)
+{
+  unsigned long long v;
+  int ret = GOMP_get_perf_counter (*counter, &v);
+
+  if (ret == 0)
+    *value = v;
+  return ret;
+}
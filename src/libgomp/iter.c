@@ -54,7 +54,10 @@ gomp_iter_static_next (long *pstart, long *pend)
       *pstart = ws->next;
       *pend = ws->end;
       thr->ts.static_trip = -1;
-      return ws->next == ws->end;
+      if (ws->next == ws->end)
+	return 1;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
+      return 0;
     }
 
   /* We interpret chunk_size zero as "unspecified", which means that we
@@ -99,6 +102,7 @@ gomp_iter_static_next (long *pstart, long *pend)
 
       *pstart = s;
       *pend = e;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
       thr->ts.static_trip = (e0 == n ? -1 : 1);
       return 0;
     }
@@ -132,6 +136,7 @@ gomp_iter_static_next (long *pstart, long *pend)
 
       *pstart = s;
       *pend = e;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 
       if (e0 == n)
 	thr->ts.static_trip = -1;
@@ -174,6 +179,7 @@ gomp_iter_dynamic_next_locked (long *pstart, long *pend)
   ws->next = end;
   *pstart = start;
   *pend = end;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 
@@ -205,6 +211,7 @@ gomp_iter_dynamic_next (long *pstart, long *pend)
 	    nend = end;
 	  *pstart = tmp;
 	  *pend = nend;
+	  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 	  return true;
 	}
       else
@@ -216,6 +223,7 @@ gomp_iter_dynamic_next (long *pstart, long *pend)
 	    nend = end;
 	  *pstart = tmp;
 	  *pend = nend;
+	  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 	  return true;
 	}
     }
@@ -250,6 +258,7 @@ gomp_iter_dynamic_next (long *pstart, long *pend)
 
   *pstart = start;
   *pend = nend;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 
@@ -289,6 +298,7 @@ found:
 	ws->thread_start[tid] = j;
 	*pstart = ws->loop_start + i;
 	*pend = ws->loop_start + j;
+	gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 
 	return (true);
 }
@@ -321,6 +331,7 @@ found:
 	ws->thread_start[tid] = i + 1;
 	*pstart = ws->loop_start + i;
 	*pend = ws->loop_start + i + 1;
+	gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 
 	return (true);
 }
@@ -358,6 +369,7 @@ gomp_iter_guided_next_locked (long *pstart, long *pend)
   ws->next = end;
   *pstart = start;
   *pend = end;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 
@@ -407,6 +419,7 @@ gomp_iter_guided_next (long *pstart, long *pend)
 
   *pstart = start;
   *pend = nend;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 #endif /* HAVE_SYNC_BUILTINS */
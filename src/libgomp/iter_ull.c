@@ -52,7 +52,10 @@ gomp_iter_ull_static_next (gomp_ull *pstart, gomp_ull *pend)
       *pstart = ws->next_ull;
       *pend = ws->end_ull;
       thr->ts.static_trip = -1;
-      return ws->next_ull == ws->end_ull;
+      if (ws->next_ull == ws->end_ull)
+	return 1;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
+      return 0;
     }
 
   /* We interpret chunk_size zero as "unspecified", which means that we
@@ -97,6 +100,7 @@ gomp_iter_ull_static_next (gomp_ull *pstart, gomp_ull *pend)
 
       *pstart = s;
       *pend = e;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
       thr->ts.static_trip = (e0 == n ? -1 : 1);
       return 0;
     }
@@ -131,6 +135,7 @@ gomp_iter_ull_static_next (gomp_ull *pstart, gomp_ull *pend)
 
       *pstart = s;
       *pend = e;
+      gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 
       if (e0 == n)
 	thr->ts.static_trip = -1;
@@ -173,6 +178,7 @@ gomp_iter_ull_dynamic_next_locked (gomp_ull *pstart, gomp_ull *pend)
   ws->next_ull = end;
   *pstart = start;
   *pend = end;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 
@@ -203,6 +209,7 @@ gomp_iter_ull_dynamic_next (gomp_ull *pstart, gomp_ull *pend)
 	    nend = end;
 	  *pstart = tmp;
 	  *pend = nend;
+	  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 	  return true;
 	}
       else
@@ -214,6 +221,7 @@ gomp_iter_ull_dynamic_next (gomp_ull *pstart, gomp_ull *pend)
 	    nend = end;
 	  *pstart = tmp;
 	  *pend = nend;
+	  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
 	  return true;
 	}
     }
@@ -248,6 +256,7 @@ gomp_iter_ull_dynamic_next (gomp_ull *pstart, gomp_ull *pend)
 
   *pstart = start;
   *pend = nend;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 #endif /* HAVE_SYNC_BUILTINS */
@@ -287,6 +296,7 @@ gomp_iter_ull_guided_next_locked (gomp_ull *pstart, gomp_ull *pend)
   ws->next_ull = end;
   *pstart = start;
   *pend = end;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 
@@ -339,6 +349,7 @@ gomp_iter_ull_guided_next (gomp_ull *pstart, gomp_ull *pend)
 
   *pstart = start;
   *pend = nend;
+  gomp_tool_event (gomp_tool_event_work_chunk, ws, *pstart, *pend);
   return true;
 }
 #endif /* HAVE_SYNC_BUILTINS */
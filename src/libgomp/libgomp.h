@@ -66,8 +66,6 @@ union tick_t
   } sub;
 };
 
-union tick_t t0, t1;
-
 #include "sem.h"
 #include "mutex.h"
 #include "bar.h"
@@ -266,9 +264,28 @@ extern struct gomp_task_icv gomp_global_icv;
 extern gomp_mutex_t gomp_managed_threads_lock;
 #endif
 extern unsigned long gomp_max_active_levels_var;
+extern int gomp_max_task_priority_var;
 extern bool gomp_cancel_var;
 extern bool gomp_binlpt_debug_var;
 extern unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+extern unsigned long gomp_task_successor_depth_var;
+extern bool gomp_task_cutoff_adaptive_var;
+extern unsigned long gomp_task_cutoff_depth_var, gomp_task_cutoff_queue_var;
+extern unsigned long gomp_task_cutoff_ns_var;
+extern unsigned long gomp_task_stacksize_var;
+extern bool gomp_numa_local_var;
+extern bool gomp_cpu_quota_var;
+extern bool gomp_adaptive_teams_var;
+extern unsigned long gomp_node_budget_var;
+extern unsigned long gomp_shared_pool_var;
+extern unsigned long gomp_prespawn_var;
+extern char *gomp_topology_root_var;
+extern char *gomp_tool_var;
+extern char *gomp_profile_var;
+extern bool gomp_profile_counters_var;
+extern bool gomp_profile_locks_var;
+extern char *gomp_trace_var;
+extern unsigned long gomp_trace_buffer_var, gomp_trace_sampling_var;
 extern unsigned long gomp_available_cpus, gomp_managed_threads;
 extern unsigned long *gomp_nthreads_var_list, gomp_nthreads_var_list_len;
 extern char *gomp_bind_var_list;
@@ -276,16 +293,35 @@ extern unsigned long gomp_bind_var_list_len;
 extern void **gomp_places_list;
 extern unsigned long gomp_places_list_len;
 
+/* True once the initialization deferred until the first use of the
+   runtime has been done, see initialize_env_lazy.  Anything that needs
+   the number of CPUs, the default of nthreads-var, bind-var or the
+   places calls gomp_init_lazy first.  */
+extern bool gomp_initialized;
+extern void gomp_init_lazy_slow (void);
+
+static inline void
+gomp_init_lazy (void)
+{
+  if (__builtin_expect (!__atomic_load_n (&gomp_initialized,
+					  MEMMODEL_ACQUIRE), 0))
+    gomp_init_lazy_slow ();
+}
+
 enum gomp_task_kind
 {
   GOMP_TASK_IMPLICIT,
   GOMP_TASK_IFFALSE,
   GOMP_TASK_WAITING,
-  GOMP_TASK_TIED
+  GOMP_TASK_TIED,
+  /* The task has returned but is detached and completes only once its
+     event is fulfilled by omp_fulfill_event.  */
+  GOMP_TASK_DETACHED
 };
 
 struct gomp_task;
 struct gomp_taskgroup;
+struct gomp_parallel_site;
 struct htab;
 
 struct gomp_task_depend_entry
@@ -326,14 +362,85 @@ struct gomp_task
   void (*fn) (void *);
   void *fn_data;
   enum gomp_task_kind kind;
+  /* Scheduling priority, already clamped to gomp_max_task_priority_var.  */
+  int priority;
+  /* Estimated cost given by GOMP_set_task_cost, 0 if unknown.  */
+  unsigned long cost;
+  /* Place whose threads should preferably run the task plus one, or zero
+     if any thread will do.  */
+  unsigned int place;
+  /* Allocation this task is part of if it was created by GOMP_task_batch
+     or GOMP_task_range, NULL if it was allocated on its own.  */
+  struct gomp_task_batch *batch;
+  /* Stack and saved registers of an untied task that has been started,
+     NULL otherwise.  */
+  struct gomp_context *context;
+  /* Number of task ancestors, used by the adaptive task cutoff.  */
+  unsigned int depth;
   bool in_taskwait;
   bool in_tied_task;
+  /* The task is untied and runs in its own context, see context.h.  */
+  bool untied;
+  /* The task is untied and suspended in GOMP_taskwait; it is requeued
+     once it can continue.  */
+  bool suspended;
   bool final_task;
   bool copy_ctors_done;
+  /* The task has an event that has not been fulfilled yet.  */
+  bool detach;
+  /* Team of a deferred detached task, which omp_fulfill_event needs to
+     complete it; NULL for undeferred ones, whose encountering thread
+     waits on completion_sem instead.  */
+  struct gomp_team *detach_team;
+  gomp_sem_t completion_sem;
   gomp_sem_t taskwait_sem;
   struct gomp_task_depend_entry depend[];
 };
 
+/* GOMP_task and GOMP_taskloop flags passed by the compiler.  */
+#define GOMP_TASK_FLAG_UNTIED		(1 << 0)
+#define GOMP_TASK_FLAG_FINAL		(1 << 1)
+#define GOMP_TASK_FLAG_MERGEABLE	(1 << 2)
+#define GOMP_TASK_FLAG_DEPEND		(1 << 3)
+#define GOMP_TASK_FLAG_PRIORITY		(1 << 4)
+#define GOMP_TASK_FLAG_UP		(1 << 8)
+#define GOMP_TASK_FLAG_GRAINSIZE	(1 << 9)
+#define GOMP_TASK_FLAG_IF		(1 << 10)
+#define GOMP_TASK_FLAG_NOGROUP		(1 << 11)
+#define GOMP_TASK_FLAG_DETACH		(1 << 13)
+
+/* Number of buckets of the team's ready queue.  Priorities up to
+   GOMP_TASK_PRIORITY_BUCKETS - 1 get a bucket each, larger values of
+   max-task-priority-var are spread evenly over the buckets.  */
+#define GOMP_TASK_PRIORITY_BUCKETS	32
+
+/* Maximum number of tasks skipped to keep a ready queue bucket or a
+   children list sorted by cost when inserting into it.  */
+#define GOMP_TASK_INSERT_WALK		32
+
+/* Ready queue of a team.  Each bucket is a circular list linked through
+   next_queue/prev_queue, ordered by decreasing cost (approximately, see
+   GOMP_TASK_INSERT_WALK) and FIFO among equal costs; buckets are served
+   from the highest non-empty one.  */
+
+struct gomp_task_queue
+{
+  /* Bit I is set iff BUCKETS[I] is non-NULL.  */
+  unsigned int nonempty;
+  /* Number of tasks in the queue, only maintained when
+     gomp_task_cutoff_adaptive_var.  */
+  unsigned int count;
+  struct gomp_task *buckets[GOMP_TASK_PRIORITY_BUCKETS];
+};
+
+/* Header of the single allocation holding the tasks of a batch.  */
+
+struct gomp_task_batch
+{
+  /* Number of tasks of the batch that have not been freed yet.  */
+  unsigned long refcount;
+};
+
 struct gomp_taskgroup
 {
   struct gomp_taskgroup *prev;
@@ -406,7 +513,10 @@ struct gomp_team
   struct gomp_work_share work_shares[8];
 
   gomp_mutex_t task_lock;
-  struct gomp_task *task_queue;
+  struct gomp_task_queue task_queue;
+  /* Ready queues of the tasks with a place hint, indexed by place, or
+     NULL until the first such task is queued.  */
+  struct gomp_task_queue *place_queues;
   /* Number of all GOMP_TASK_{WAITING,TIED} tasks in the team.  */
   unsigned int task_count;
   /* Number of GOMP_TASK_WAITING tasks currently waiting to be scheduled.  */
@@ -419,8 +529,22 @@ struct gomp_team
      and if current task isn't in_tied_task, then it will be
      even < team->nthreads.  */
   unsigned int task_running_count;
+  /* Moving average of the run time of deferred tasks in nanoseconds,
+     excluding that of deferred tasks run while they wait,
+     0 until the first one finishes.  Only maintained when
+     gomp_task_cutoff_adaptive_var.  */
+  unsigned long task_avg_ns;
   int work_share_cancelled;
   int team_cancelled;
+  /* True if the threads of the team come from the process-wide pool of
+     GOMP_SHARED_POOL rather than from the pool of the master.  */
+  bool shared_pool;
+  /* Schedule kind and chunk size of the work share of a combined
+     parallel loop or sections construct, which each thread finds set up
+     when it starts, for gomp_tool_event_work_begin.  The kind is -1 if
+     there is no such work share.  */
+  int tool_work_kind;
+  long tool_work_chunk;
 
   /* This array contains structures for implicit tasks.  */
   struct gomp_task implicit_task[];
@@ -451,6 +575,54 @@ struct gomp_thread
 
   /* User pthread thread pool */
   struct gomp_thread_pool *thread_pool;
+
+  /* Cost hint for the next task this thread creates, set by
+     GOMP_set_task_cost.  */
+  unsigned long task_cost;
+
+  /* Place hint plus one for the next task this thread creates, set by
+     GOMP_set_task_affinity or GOMP_set_task_place.  */
+  unsigned int task_place;
+
+  /* Nanoseconds spent so far running deferred tasks nested in the task
+     this thread is timing, see gomp_task_run_fn.  */
+  unsigned long task_nested_ns;
+
+  /* Two implicit tasks allocated by this thread, so that they are on its
+     NUMA node, used in turn when it is a worker of a team instead of
+     those of the team, or NULL.  See gomp_thread_numa_local.  */
+  struct gomp_task *implicit_tasks;
+
+  /* Call site of the top-level parallel region this thread is the master
+     of, if its team size is chosen adaptively, and the time the region
+     started.  See gomp_adaptive_num_threads.  */
+  struct gomp_parallel_site *parallel_site;
+  double parallel_start;
+
+  /* Threads besides this one of the top-level team it is the master of
+     registered in the node budget, see gomp_node_budget_acquire.  */
+  unsigned int node_threads;
+
+  /* Workers of the shared pool reserved for the next top-level team this
+     thread starts, see gomp_shared_pool_reserve.  */
+  unsigned int shared_workers;
+
+  /* Return address of the construct whose barrier the thread is about to
+     wait in, for the tool.  Only set while a tool is attached.  */
+  void *tool_site;
+
+  /* Whether the lock of the last lock_wait_begin event of the thread was
+     held by another thread, see gomp_tool_lock_tried.  */
+  bool lock_contended;
+
+  /* Data of GOMP_PROFILE for this thread, or NULL.  */
+  struct gomp_profile_thread *profile;
+
+  /* Performance counters of this thread, or NULL if not opened yet.  */
+  struct gomp_perf_thread *perf;
+
+  /* Event buffer of GOMP_TRACE for this thread, or NULL.  */
+  struct gomp_trace_thread *trace;
 };
 
 
@@ -507,7 +679,11 @@ static inline struct gomp_task_icv *gomp_icv (bool write)
   else if (write)
     return gomp_new_icv ();
   else
-    return &gomp_global_icv;
+    {
+      /* Copies of the global ICVs are taken from here.  */
+      gomp_init_lazy ();
+      return &gomp_global_icv;
+    }
 }
 
 /* The attributes to be used during thread creation.  */
@@ -518,6 +694,7 @@ extern pthread_attr_t gomp_thread_attr;
 /* affinity.c */
 
 extern void gomp_init_affinity (void);
+extern void gomp_init_master_affinity (void);
 extern void gomp_init_thread_affinity (pthread_attr_t *, unsigned int);
 extern void **gomp_affinity_alloc (unsigned long, bool);
 extern void gomp_affinity_init_place (void *);
@@ -529,6 +706,30 @@ extern bool gomp_affinity_same_place (void *, void *);
 extern bool gomp_affinity_finalize_place_list (bool);
 extern bool gomp_affinity_init_level (int, unsigned long, bool);
 extern void gomp_affinity_print_place (void *);
+extern int gomp_affinity_place_of_address (const void *);
+extern bool gomp_affinity_multinode_p (void);
+extern int gomp_affinity_place_node (unsigned long);
+extern void gomp_affinity_move_local (void *, size_t);
+
+/* budget.c */
+
+/* Active threads of all processes in the GOMP_NODE_BUDGET segment, or
+   NULL if there is no node budget.  */
+extern unsigned long *gomp_node_active;
+extern void gomp_init_node_budget (void);
+extern unsigned gomp_node_budget_acquire (unsigned, bool);
+extern void gomp_node_budget_release (unsigned);
+
+/* Return true if the processes on the node run more threads than the
+   node budget, in which case waiting threads should not spin long.  */
+
+static inline bool
+gomp_node_oversubscribed_p (void)
+{
+  return gomp_node_active != NULL
+	 && __atomic_load_n (gomp_node_active, MEMMODEL_RELAXED)
+	    > gomp_node_budget_var;
+}
 
 /* alloc.c */
 
@@ -540,6 +741,10 @@ extern void *gomp_realloc (void *, size_t);
    GCC's builtin alloca().  */
 #define gomp_alloca(x)  __builtin_alloca(x)
 
+/* critical.c */
+
+extern const void *const gomp_critical_default_lock;
+
 /* error.c */
 
 extern void gomp_error (const char *, ...)
@@ -576,6 +781,11 @@ extern bool gomp_iter_ull_guided_next (unsigned long long *,
 				       unsigned long long *);
 #endif
 
+/* loop.c */
+
+extern unsigned *gomp_loop_workload_chunksizes (unsigned, unsigned);
+extern void gomp_loop_taskmaps_free (void);
+
 /* ordered.c */
 
 extern void gomp_ordered_first (void);
@@ -587,12 +797,15 @@ extern void gomp_ordered_sync (void);
 
 /* parallel.c */
 
-extern unsigned gomp_resolve_num_threads (unsigned, unsigned);
+extern unsigned gomp_resolve_num_threads (unsigned, unsigned,
+					  void (*) (void *));
+extern void gomp_parallel_async_free (void);
 
 /* proc.c (in config/) */
 
 extern void gomp_init_num_threads (void);
 extern unsigned gomp_dynamic_max_threads (void);
+extern void gomp_release_stack (void);
 
 /* task.c */
 
@@ -616,11 +829,143 @@ extern void gomp_team_start (void (*) (void *), void *, unsigned,
 			     unsigned, struct gomp_team *);
 extern void gomp_team_end (void);
 extern void gomp_free_thread (void *);
+extern void gomp_free_thread_at_exit (struct gomp_thread *);
+extern void gomp_free_thread_pool (struct gomp_thread *);
+extern unsigned gomp_shared_pool_reserve (unsigned);
+extern void gomp_prespawn (void);
+
+/* perf.c */
+
+/* The counters of gomp_perf_counter_t.  */
+#define GOMP_PERF_COUNTERS 5
+
+extern unsigned int gomp_perf_read (uint64_t *);
+extern void gomp_perf_free_thread (struct gomp_thread *);
+
+/* profile.c */
+
+extern bool gomp_profile_enabled;
+extern void gomp_init_profile (void);
+extern void gomp_profile_free_thread (struct gomp_thread *);
+extern void gomp_profile_event (int, const void *, unsigned long,
+				unsigned long);
+extern void gomp_profile_symbol (char *, size_t, const void *);
+
+/* Return a timestamp in ticks of the time stamp counter where there is
+   one, else in nanoseconds.  */
+
+static inline uint64_t
+gomp_profile_ticks (void)
+{
+#if defined __x86_64__ || defined __i386__
+  union tick_t t;
+
+  __asm__ __volatile__ ("rdtsc" : "=a" (t.sub.low), "=d" (t.sub.high));
+  return t.tick;
+#else
+  return omp_get_wtime () * 1e9;
+#endif
+}
+
+/* trace.c */
+
+extern bool gomp_trace_enabled;
+extern void gomp_init_trace (void);
+extern void gomp_trace_free_thread (struct gomp_thread *);
+extern void gomp_trace_event (int, const void *, unsigned long,
+			      unsigned long);
+
+/* tool.c */
+
+extern bool gomp_tool_enabled;
+extern void gomp_init_tool (void);
+extern void gomp_tool_dispatch (int, const void *, unsigned long,
+				unsigned long);
+extern void gomp_tool_implicit_task_begin (struct gomp_team *, unsigned,
+					   void (*) (void *));
+extern void gomp_tool_work_end (void *, bool);
+extern void gomp_tool_barrier_wait_begin (gomp_barrier_t *);
+extern void gomp_tool_barrier_wait_end (gomp_barrier_t *);
+extern void gomp_tool_lock_tested (const void *, int, unsigned long);
+
+/* Report EVENT, one of gomp_tool_event_t, to the tool if any is
+   attached.  */
+
+static inline void
+gomp_tool_event (int event, const void *object, unsigned long arg0,
+		 unsigned long arg1)
+{
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_dispatch (event, object, arg0, arg1);
+}
+
+/* With a tool attached, the lock routines first try to take the lock
+   without waiting, so that whether it was held by another thread is
+   known when it is acquired.  Record whether that attempt TAKEN the
+   lock, and return TAKEN.  */
+
+static inline bool
+gomp_tool_lock_tried (bool taken)
+{
+  gomp_thread ()->lock_contended = !taken;
+  return taken;
+}
+
+/* Try to take MUTEX if a tool is attached, see gomp_tool_lock_tried.  If
+   this returns false, the caller has to wait for MUTEX.  */
+
+static inline bool
+gomp_tool_mutex_trylock (gomp_mutex_t *mutex)
+{
+  return (__builtin_expect (gomp_tool_enabled, 0)
+	  && gomp_tool_lock_tried (gomp_mutex_trylock (mutex)));
+}
 
 /* target.c */
 
 extern int gomp_get_num_devices (void);
 
+/* topology.c */
+
+enum gomp_topology_level
+{
+  GOMP_TOPOLOGY_CORE,
+  GOMP_TOPOLOGY_L2,
+  GOMP_TOPOLOGY_L3,
+  GOMP_TOPOLOGY_NUMA,
+  GOMP_TOPOLOGY_SOCKET,
+  GOMP_TOPOLOGY_LEVELS
+};
+
+/* The machine topology, from the CPU up to the socket.  Each level
+   splits the CPUs into ndomains[level] domains, numbered densely in the
+   order of their lowest CPU; ids[level * ncpus + cpu] is the domain of
+   CPU at LEVEL.  A level the system knows nothing about is as fine as
+   the level below it, or is a single domain for NUMA nodes and
+   sockets.  */
+
+struct gomp_topology
+{
+  unsigned int ncpus;
+  unsigned int ndomains[GOMP_TOPOLOGY_LEVELS];
+  int *ids;
+  /* The operating system number of each NUMA domain.  */
+  int *numa_node;
+};
+
+extern const struct gomp_topology *gomp_get_topology (void);
+
+/* Return the domain of CPU at LEVEL, or -1 if CPU is unknown.  */
+
+static inline int
+gomp_topology_domain (const struct gomp_topology *topo,
+		      enum gomp_topology_level level, unsigned long cpu)
+{
+  if (cpu >= topo->ncpus)
+    return -1;
+  return topo->ids[level * topo->ncpus + cpu];
+}
+
 /* work.c */
 
 extern void gomp_init_work_share (struct gomp_work_share *, bool, unsigned);
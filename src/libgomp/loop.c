@@ -104,6 +104,18 @@ void omp_loop_unregister(unsigned loop_id)
   loops[loop_id].name = NULL;
 }
 
+/**
+ * @brief Frees the task maps of all registered loops, for omp_pause_resource.
+ * They are computed again the next time each loop runs.
+ */
+void gomp_loop_taskmaps_free(void)
+{
+  for (size_t i = 0; i < NR_LOOPS; i++) {
+    free(loops[i].taskmap);
+    loops[i].taskmap = NULL;
+  }
+}
+
 /**
  * @brief Sets the workload of the next parallel for loop.
  *
@@ -456,6 +468,24 @@ static unsigned *binlpt_balance(unsigned *tasks, unsigned ntasks, unsigned nthre
   return (taskmap);
 }
 
+/**
+ * @brief Splits a loop into chunks of about the same weight.
+ *
+ * @param ntasks  Number of iterations of the loop.
+ * @param nchunks Number of chunks.
+ *
+ * @returns Chunk sizes, to be released with free(), or NULL if the
+ *          workload set with omp_set_workload() does not describe a loop
+ *          of @p ntasks iterations. Trailing chunks may be empty.
+ */
+unsigned *gomp_loop_workload_chunksizes(unsigned ntasks, unsigned nchunks)
+{
+  if ((__tasks == NULL) || (__ntasks != ntasks) || (nchunks == 0))
+    return (NULL);
+
+  return (compute_chunksizes(__tasks, ntasks, nchunks));
+}
+
 /*============================================================================*
  * Hacked LibGomp Routines                                                    *
  *============================================================================*/
@@ -566,6 +596,8 @@ gomp_loop_static_start (long start, long end, long incr, long chunk_size,
           GFS_STATIC, chunk_size, 0);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_STATIC, chunk_size);
 
   return !gomp_iter_static_next (istart, iend);
 }
@@ -583,6 +615,8 @@ gomp_loop_dynamic_start (long start, long end, long incr, long chunk_size,
           GFS_DYNAMIC, chunk_size, 0);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_DYNAMIC, chunk_size);
 
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_dynamic_next (istart, iend);
@@ -608,6 +642,8 @@ gomp_loop_guided_start (long start, long end, long incr, long chunk_size,
           GFS_GUIDED, chunk_size, 0);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_GUIDED, chunk_size);
 
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_guided_next (istart, iend);
@@ -633,6 +669,8 @@ gomp_loop_binlpt_start (long start, long end, long incr, long chunk_size,
           GFS_BINLPT, chunk_size, 0);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_BINLPT, chunk_size);
 
   ret = gomp_iter_binlpt_next (istart, iend);
 
@@ -652,6 +690,8 @@ gomp_loop_srr_start (long start, long end, long incr, long chunk_size,
           GFS_SRR, chunk_size, 0);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_SRR, chunk_size);
 
   ret = gomp_iter_srr_next (istart, iend);
 
@@ -706,6 +746,8 @@ gomp_loop_ordered_static_start (long start, long end, long incr,
       gomp_ordered_static_init ();
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_STATIC, chunk_size);
 
   return !gomp_iter_static_next (istart, iend);
 }
@@ -726,6 +768,8 @@ gomp_loop_ordered_dynamic_start (long start, long end, long incr,
     }
   else
     gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_DYNAMIC, chunk_size);
 
   ret = gomp_iter_dynamic_next_locked (istart, iend);
   if (ret)
@@ -751,6 +795,8 @@ gomp_loop_ordered_guided_start (long start, long end, long incr,
     }
   else
     gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+                   GFS_GUIDED, chunk_size);
 
   ret = gomp_iter_guided_next_locked (istart, iend);
   if (ret)
@@ -963,9 +1009,11 @@ gomp_parallel_loop_start (void (*fn) (void *), void *data,
 {
   struct gomp_team *team;
 
-  num_threads = gomp_resolve_num_threads (num_threads, 0);
+  num_threads = gomp_resolve_num_threads (num_threads, 0, fn);
   team = gomp_new_team (num_threads);
   gomp_loop_init (&team->work_shares[0], start, end, incr, sched, chunk_size, num_threads);
+  team->tool_work_kind = sched;
+  team->tool_work_chunk = chunk_size;
   gomp_team_start (fn, data, num_threads, flags, team);
 }
 
@@ -1061,6 +1109,8 @@ GOMP_parallel_loop_runtime (void (*fn) (void *), void *data,
 void
 GOMP_loop_end (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), true);
   gomp_work_share_end ();
 }
 
@@ -1068,12 +1118,16 @@ GOMP_loop_end (void)
 bool
 GOMP_loop_end_cancel (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), true);
   return gomp_work_share_end_cancel ();
 }
 
 void
 GOMP_loop_end_nowait (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), false);
   gomp_work_share_end_nowait ();
 }
 
@@ -109,6 +109,8 @@ gomp_loop_ull_static_start (bool up, gomp_ull start, gomp_ull end,
 			  GFS_STATIC, chunk_size);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_STATIC, chunk_size);
 
   return !gomp_iter_ull_static_next (istart, iend);
 }
@@ -127,6 +129,8 @@ gomp_loop_ull_dynamic_start (bool up, gomp_ull start, gomp_ull end,
 			  GFS_DYNAMIC, chunk_size);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_DYNAMIC, chunk_size);
 
 #if defined HAVE_SYNC_BUILTINS && defined __LP64__
   ret = gomp_iter_ull_dynamic_next (istart, iend);
@@ -153,6 +157,8 @@ gomp_loop_ull_guided_start (bool up, gomp_ull start, gomp_ull end,
 			  GFS_GUIDED, chunk_size);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_GUIDED, chunk_size);
 
 #if defined HAVE_SYNC_BUILTINS && defined __LP64__
   ret = gomp_iter_ull_guided_next (istart, iend);
@@ -212,6 +218,8 @@ gomp_loop_ull_ordered_static_start (bool up, gomp_ull start, gomp_ull end,
       gomp_ordered_static_init ();
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_STATIC, chunk_size);
 
   return !gomp_iter_ull_static_next (istart, iend);
 }
@@ -233,6 +241,8 @@ gomp_loop_ull_ordered_dynamic_start (bool up, gomp_ull start, gomp_ull end,
     }
   else
     gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_DYNAMIC, chunk_size);
 
   ret = gomp_iter_ull_dynamic_next_locked (istart, iend);
   if (ret)
@@ -259,6 +269,8 @@ gomp_loop_ull_ordered_guided_start (bool up, gomp_ull start, gomp_ull end,
     }
   else
     gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share,
+		   GFS_GUIDED, chunk_size);
 
   ret = gomp_iter_ull_guided_next_locked (istart, iend);
   if (ret)
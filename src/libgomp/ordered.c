@@ -216,7 +216,13 @@ gomp_ordered_sync (void)
   __atomic_thread_fence (MEMMODEL_ACQ_REL);
   if (ws->ordered_owner != thr->ts.team_id)
     {
+      gomp_tool_event (gomp_tool_event_lock_wait_begin, ws,
+		       gomp_tool_mutex_ordered,
+		       (unsigned long) __builtin_return_address (0));
       gomp_sem_wait (team->ordered_release[thr->ts.team_id]);
+      gomp_tool_event (gomp_tool_event_lock_wait_end, ws,
+		       gomp_tool_mutex_ordered,
+		       (unsigned long) __builtin_return_address (0));
       ws->ordered_owner = thr->ts.team_id;
     }
 }
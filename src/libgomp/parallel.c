@@ -26,16 +26,170 @@
 
 #include "libgomp.h"
 #include <limits.h>
+#include <string.h>
+
+
+/* Number of call sites whose team size can be chosen adaptively.  */
+#define GOMP_PARALLEL_SITES 128
+/* Number of runs timed for each team size tried.  */
+#define GOMP_PARALLEL_SITE_SAMPLES 3
+/* Number of runs with the chosen team size before searching again.  */
+#define GOMP_PARALLEL_SITE_PERIOD 256
+
+/* Adaptive team size of the top-level parallel regions with outlined
+   function FN, see gomp_adaptive_num_threads.  */
+
+struct gomp_parallel_site
+{
+  void (*fn) (void *);
+  /* Team size requested by nthreads-var when the search started.  */
+  unsigned requested;
+  /* Team size being timed while SEARCHING, else the chosen one.  */
+  unsigned nthreads;
+  /* Fastest team size found so far and its time.  */
+  unsigned best_nthreads;
+  double best_time;
+  /* Shortest time of the runs with NTHREADS and their number.  */
+  double time;
+  unsigned runs;
+  bool searching;
+  /* Protects the fields above but FN, which is set once when the site
+     is claimed.  */
+  gomp_mutex_t lock;
+};
+
+static struct gomp_parallel_site gomp_parallel_sites[GOMP_PARALLEL_SITES];
+/* Protects the lists of drivers of asynchronous parallel regions.  */
+static gomp_mutex_t gomp_parallel_async_lock;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_parallel (void)
+{
+  unsigned i;
+
+  for (i = 0; i < GOMP_PARALLEL_SITES; i++)
+    gomp_mutex_init (&gomp_parallel_sites[i].lock);
+  gomp_mutex_init (&gomp_parallel_async_lock);
+}
+#endif
+
+static void
+gomp_parallel_site_search (struct gomp_parallel_site *site,
+			   unsigned requested)
+{
+  site->requested = requested;
+  site->nthreads = requested;
+  site->best_nthreads = requested;
+  site->best_time = 0;
+  site->runs = 0;
+  site->searching = true;
+}
+
+/* Return the team size for a top-level parallel region with outlined
+   function FN, REQUESTED threads in nthreads-var and at most
+   MAX_NUM_THREADS threads given the load, and start timing it for
+   GOMP_parallel_end.  Each call site is searched by halving the team
+   size, starting from REQUESTED, as long as the shortest of
+   GOMP_PARALLEL_SITE_SAMPLES runs gets faster, down to a single thread
+   for regions too small to be worth forking.  The fastest size is then
+   used for GOMP_PARALLEL_SITE_PERIOD runs before searching again, in
+   case the work of the region has changed.  The search only starts
+   over early when REQUESTED changes, not when the load does.  */
+
+static unsigned
+gomp_adaptive_num_threads (struct gomp_thread *thr, void (*fn) (void *),
+			   unsigned requested, unsigned max_num_threads)
+{
+  struct gomp_parallel_site *site;
+  uintptr_t hash = (uintptr_t) fn >> 4;
+  unsigned i;
+
+  for (i = 0; i < GOMP_PARALLEL_SITES; i++)
+    {
+      void (*cur) (void *);
+
+      site = &gomp_parallel_sites[(hash + i) % GOMP_PARALLEL_SITES];
+      cur = __atomic_load_n (&site->fn, MEMMODEL_ACQUIRE);
+      /* A new site has REQUESTED 0, so it starts searching below.  */
+      if (cur == NULL
+	  && __atomic_compare_exchange_n (&site->fn, &cur, fn, false,
+					  MEMMODEL_ACQ_REL, MEMMODEL_ACQUIRE))
+	break;
+      if (cur == fn)
+	break;
+    }
+  if (i == GOMP_PARALLEL_SITES)
+    return max_num_threads;
+
+  gomp_mutex_lock (&site->lock);
+  /* Start again if nthreads-var changed.  */
+  if (site->requested != requested)
+    gomp_parallel_site_search (site, requested);
+  if (site->nthreads < max_num_threads)
+    max_num_threads = site->nthreads;
+  gomp_mutex_unlock (&site->lock);
+
+  thr->parallel_site = site;
+  thr->parallel_start = omp_get_wtime ();
+  return max_num_threads;
+}
+
+/* Account a run of SITE with a team of NTHREADS threads that took TIME
+   seconds.  */
+
+static void
+gomp_parallel_site_record (struct gomp_parallel_site *site,
+			   unsigned nthreads, double time)
+{
+  gomp_mutex_lock (&site->lock);
+  /* The team may have got fewer threads than the size being timed, as
+     the load, the node budget or the shared pool allowed; time the size it
+     ran with instead.  */
+  if (site->searching && nthreads != site->nthreads)
+    {
+      site->nthreads = nthreads;
+      site->runs = 0;
+    }
+  if (site->runs++ == 0 || time < site->time)
+    site->time = time;
+  if (site->searching)
+    {
+      if (site->runs >= GOMP_PARALLEL_SITE_SAMPLES)
+	{
+	  bool faster = site->best_time == 0 || site->time < site->best_time;
+
+	  if (faster)
+	    {
+	      site->best_nthreads = site->nthreads;
+	      site->best_time = site->time;
+	    }
+	  site->runs = 0;
+	  if (faster && site->nthreads > 1)
+	    site->nthreads /= 2;
+	  else
+	    {
+	      site->nthreads = site->best_nthreads;
+	      site->searching = false;
+	    }
+	}
+    }
+  else if (site->runs >= GOMP_PARALLEL_SITE_PERIOD)
+    gomp_parallel_site_search (site, site->requested);
+  gomp_mutex_unlock (&site->lock);
+}
 
 
 /* Determine the number of threads to be launched for a PARALLEL construct.
    This algorithm is explicitly described in OpenMP 3.0 section 2.4.1.
    SPECIFIED is a combination of the NUM_THREADS clause and the IF clause.
    If the IF clause is false, SPECIFIED is forced to 1.  When NUM_THREADS
-   is not present, SPECIFIED is 0.  */
+   is not present, SPECIFIED is 0.  FN is the outlined function of the
+   region, which identifies its call site for GOMP_ADAPTIVE_TEAMS.  */
 
 unsigned
-gomp_resolve_num_threads (unsigned specified, unsigned count)
+gomp_resolve_num_threads (unsigned specified, unsigned count,
+			  void (*fn) (void *))
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_task_icv *icv;
@@ -73,6 +227,43 @@ gomp_resolve_num_threads (unsigned specified, unsigned count)
 	max_num_threads = count;
     }
 
+  /* Without a NUM_THREADS clause and with dynamic adjustment enabled, a
+     top-level region may get fewer threads if it has run faster that
+     way.  */
+  if (__builtin_expect (gomp_adaptive_teams_var, 0)
+      && icv->dyn_var && specified == 0 && thr->ts.team == NULL
+      && max_num_threads > 1)
+    max_num_threads = gomp_adaptive_num_threads (thr, fn, threads_requested,
+						 max_num_threads);
+
+  /* Top-level teams are registered in the node budget, and sized to fit
+     in it without a NUM_THREADS clause.  */
+  if (__builtin_expect (gomp_node_active != NULL, 0)
+      && thr->ts.team == NULL && max_num_threads > 1)
+    {
+      if (max_num_threads > icv->thread_limit_var)
+	max_num_threads = icv->thread_limit_var;
+      max_num_threads = gomp_node_budget_acquire (max_num_threads,
+						  specified == 0);
+      thr->node_threads = max_num_threads - 1;
+    }
+
+  /* With a process-wide pool, top-level teams borrow their threads from
+     it and may get fewer than requested.  */
+  if (__builtin_expect (gomp_shared_pool_var != 0, 0)
+      && thr->ts.team == NULL && max_num_threads > 1)
+    {
+      if (max_num_threads > icv->thread_limit_var)
+	max_num_threads = icv->thread_limit_var;
+      max_num_threads = gomp_shared_pool_reserve (max_num_threads);
+      if (thr->node_threads > max_num_threads - 1)
+	{
+	  gomp_node_budget_release (thr->node_threads
+				    - (max_num_threads - 1));
+	  thr->node_threads = max_num_threads - 1;
+	}
+    }
+
   /* UINT_MAX stands for infinity.  */
   if (__builtin_expect (icv->thread_limit_var == UINT_MAX, 1)
       || max_num_threads == 1)
@@ -121,7 +312,7 @@ gomp_resolve_num_threads (unsigned specified, unsigned count)
 void
 GOMP_parallel_start (void (*fn) (void *), void *data, unsigned num_threads)
 {
-  num_threads = gomp_resolve_num_threads (num_threads, 0);
+  num_threads = gomp_resolve_num_threads (num_threads, 0, fn);
   gomp_team_start (fn, data, num_threads, 0, gomp_new_team (num_threads));
 }
 
@@ -129,11 +320,11 @@ void
 GOMP_parallel_end (void)
 {
   struct gomp_task_icv *icv = gomp_icv (false);
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_team *team = thr->ts.team;
+  unsigned int nthreads = team ? team->nthreads : 1;
   if (__builtin_expect (icv->thread_limit_var != UINT_MAX, 0))
     {
-      struct gomp_thread *thr = gomp_thread ();
-      struct gomp_team *team = thr->ts.team;
-      unsigned int nthreads = team ? team->nthreads : 1;
       gomp_team_end ();
       if (nthreads > 1)
 	{
@@ -156,13 +347,26 @@ GOMP_parallel_end (void)
     }
   else
     gomp_team_end ();
+
+  if (__builtin_expect (thr->parallel_site != NULL, 0)
+      && thr->ts.team == NULL)
+    {
+      gomp_parallel_site_record (thr->parallel_site, nthreads,
+				 omp_get_wtime () - thr->parallel_start);
+      thr->parallel_site = NULL;
+    }
+  if (__builtin_expect (thr->node_threads != 0, 0) && thr->ts.team == NULL)
+    {
+      gomp_node_budget_release (thr->node_threads);
+      thr->node_threads = 0;
+    }
 }
 ialias (GOMP_parallel_end)
 
 void
 GOMP_parallel (void (*fn) (void *), void *data, unsigned num_threads, unsigned int flags)
 {
-  num_threads = gomp_resolve_num_threads (num_threads, 0);
+  num_threads = gomp_resolve_num_threads (num_threads, 0, fn);
   gomp_team_start (fn, data, num_threads, flags, gomp_new_team (num_threads));
   fn (data);
   ialias_call (GOMP_parallel_end) ();
@@ -230,6 +434,177 @@ GOMP_cancel (int which, bool do_cancel)
   return true;
 }
 
+/* Asynchronous parallel regions.  The region is started by a driver
+   thread, which becomes the master of its team in place of the calling
+   thread and has a thread pool of its own.  A driver stays on the busy
+   list until its region has been waited for, as the handle refers to
+   it, and is then kept on an idle list so that its pool is reused.  So
+   every handle must be passed to GOMP_parallel_wait; the driver of a
+   region that is never waited for is only freed at exit, though
+   omp_pause_resource lets it free its pool once the region ended.  */
+
+struct gomp_parallel_async
+{
+  void (*fn) (void *);
+  void *data;
+  unsigned num_threads;
+  /* ICVs of the thread that started the region.  */
+  struct gomp_task_icv icv;
+  /* Posted to start the region, with FN NULL to let the driver exit, or
+     with RELEASE set to let it free its thread pool.  Each post is made
+     with gomp_parallel_async_lock held, together with setting the field
+     it goes with, and the driver consumes RELEASE before FN.  */
+  gomp_sem_t start;
+  /* Posted when the region has ended.  */
+  gomp_sem_t finished;
+  int done;
+  bool release;
+  struct gomp_parallel_async *next, *prev;
+};
+
+static struct gomp_parallel_async *gomp_parallel_async_idle;
+static struct gomp_parallel_async *gomp_parallel_async_busy;
+
+static void *
+gomp_parallel_async_driver (void *arg)
+{
+  struct gomp_parallel_async *d = arg;
+  void (*fn) (void *);
+  bool release;
+
+  while (1)
+    {
+      gomp_sem_wait (&d->start);
+      gomp_mutex_lock (&gomp_parallel_async_lock);
+      release = d->release;
+      d->release = false;
+      fn = d->fn;
+      gomp_mutex_unlock (&gomp_parallel_async_lock);
+      if (release)
+	{
+	  gomp_free_thread_pool (gomp_thread ());
+	  continue;
+	}
+      if (fn == NULL)
+	break;
+      *gomp_icv (true) = d->icv;
+      GOMP_parallel (fn, d->data, d->num_threads, 0);
+      __atomic_store_n (&d->done, 1, MEMMODEL_RELEASE);
+      gomp_sem_post (&d->finished);
+    }
+
+  gomp_sem_destroy (&d->start);
+  gomp_sem_destroy (&d->finished);
+  free (d);
+  return NULL;
+}
+
+/* Start a parallel region running FN (DATA) on NUM_THREADS threads, or
+   as many as a parallel region without a num_threads clause if it is
+   not positive, none of which is the calling thread, and return without
+   waiting for it.  */
+
+gomp_parallel_handle_t
+GOMP_parallel_async (void (*fn) (void *), void *data, int num_threads)
+{
+  struct gomp_parallel_async *d;
+
+  gomp_mutex_lock (&gomp_parallel_async_lock);
+  d = gomp_parallel_async_idle;
+  if (d != NULL)
+    gomp_parallel_async_idle = d->next;
+  gomp_mutex_unlock (&gomp_parallel_async_lock);
+
+  if (d == NULL)
+    {
+      pthread_t pt;
+      int err;
+
+      d = gomp_malloc (sizeof (*d));
+      gomp_sem_init (&d->start, 0);
+      gomp_sem_init (&d->finished, 0);
+      d->release = false;
+      err = pthread_create (&pt, &gomp_thread_attr,
+			    gomp_parallel_async_driver, d);
+      if (err != 0)
+	gomp_fatal ("Thread creation failed: %s", strerror (err));
+    }
+
+  d->data = data;
+  d->num_threads = num_threads > 0 ? num_threads : 0;
+  d->icv = *gomp_icv (false);
+  d->done = 0;
+
+  gomp_mutex_lock (&gomp_parallel_async_lock);
+  d->fn = fn;
+  d->prev = NULL;
+  d->next = gomp_parallel_async_busy;
+  if (d->next != NULL)
+    d->next->prev = d;
+  gomp_parallel_async_busy = d;
+  gomp_sem_post (&d->start);
+  gomp_mutex_unlock (&gomp_parallel_async_lock);
+  return (gomp_parallel_handle_t) d;
+}
+
+/* Wait for the region started with HANDLE to end.  HANDLE is invalid
+   afterwards.  */
+
+void
+GOMP_parallel_wait (gomp_parallel_handle_t handle)
+{
+  struct gomp_parallel_async *d = (struct gomp_parallel_async *) handle;
+
+  gomp_sem_wait (&d->finished);
+  gomp_mutex_lock (&gomp_parallel_async_lock);
+  if (d->prev != NULL)
+    d->prev->next = d->next;
+  else
+    gomp_parallel_async_busy = d->next;
+  if (d->next != NULL)
+    d->next->prev = d->prev;
+  d->next = gomp_parallel_async_idle;
+  gomp_parallel_async_idle = d;
+  gomp_mutex_unlock (&gomp_parallel_async_lock);
+}
+
+/* Return nonzero if the region started with HANDLE has ended.  */
+
+int
+GOMP_parallel_test (gomp_parallel_handle_t handle)
+{
+  struct gomp_parallel_async *d = (struct gomp_parallel_async *) handle;
+
+  return __atomic_load_n (&d->done, MEMMODEL_ACQUIRE);
+}
+
+/* Let the idle drivers exit, freeing their thread pools, and let the
+   drivers of regions that ended but have not been waited for yet free
+   their pools.  */
+
+void
+gomp_parallel_async_free (void)
+{
+  struct gomp_parallel_async *d, *next;
+
+  gomp_mutex_lock (&gomp_parallel_async_lock);
+  for (d = gomp_parallel_async_busy; d != NULL; d = d->next)
+    if (__atomic_load_n (&d->done, MEMMODEL_ACQUIRE) && !d->release)
+      {
+	d->release = true;
+	gomp_sem_post (&d->start);
+      }
+  d = gomp_parallel_async_idle;
+  gomp_parallel_async_idle = NULL;
+  for (; d != NULL; d = next)
+    {
+      next = d->next;
+      d->fn = NULL;
+      gomp_sem_post (&d->start);
+    }
+  gomp_mutex_unlock (&gomp_parallel_async_lock);
+}
+
 /* The public OpenMP API for thread and team related inquiries.  */
 
 int
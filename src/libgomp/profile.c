@@ -0,0 +1,984 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file contains the profiler enabled by GOMP_PROFILE.  It times the
+   events of the tool interface on each thread and aggregates them by
+   outlined function or call site, in a table private to the thread.  The
+   tables are merged when the program exits and the summary is written
+   out.  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include "libgomp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_DLFCN_H
+# include <dlfcn.h>
+#endif
+
+/* Sites recorded per thread and in the merged table, powers of 2.  */
+#define GOMP_PROFILE_SITES 256
+#define GOMP_PROFILE_MERGED_SITES 4096
+/* Nesting of regions and tasks followed per thread.  */
+#define GOMP_PROFILE_DEPTH 8
+/* Wait histograms have buckets of powers of 2 ticks, the first one for
+   less than 1 << GOMP_PROFILE_MIN_BUCKET ticks.  */
+#define GOMP_PROFILE_BUCKETS 24
+#define GOMP_PROFILE_MIN_BUCKET 8
+/* Sites listed per table of the summary.  */
+#define GOMP_PROFILE_TOP 20
+/* Locks followed with GOMP_PROFILE_LOCKS, a power of 2.  */
+#define GOMP_PROFILE_LOCK_ENTRIES 4096
+
+enum gomp_profile_kind
+{
+  /* Parallel regions, by outlined function.  */
+  GOMP_PROFILE_REGION,
+  /* Barriers of the program, by call site.  */
+  GOMP_PROFILE_BARRIER,
+  /* Barriers at the end of parallel regions, by outlined function.  */
+  GOMP_PROFILE_JOIN,
+  /* Lock waits by call site, one kind per gomp_tool_mutex_t.  */
+  GOMP_PROFILE_LOCK,
+  GOMP_PROFILE_NEST_LOCK,
+  GOMP_PROFILE_CRITICAL,
+  GOMP_PROFILE_ORDERED,
+  GOMP_PROFILE_ATOMIC,
+  /* Explicit tasks, by task function.  */
+  GOMP_PROFILE_TASK,
+  /* Loop and sections constructs, by call site of their end.  */
+  GOMP_PROFILE_WORK
+};
+
+struct gomp_profile_site
+{
+  const void *site;
+  int kind;
+  bool used;
+  unsigned long count;
+  uint64_t ticks, max;
+  /* For regions, the time of their threads and the part of it spent
+     waiting in barriers; for work shares, the schedule kind and chunk
+     size.  */
+  uint64_t aux[2];
+  unsigned int hist[GOMP_PROFILE_BUCKETS];
+  /* For regions and work shares, the increase of the performance counters
+     of their threads with GOMP_PROFILE_COUNTERS.  */
+  uint64_t counters[GOMP_PERF_COUNTERS];
+};
+
+/* An implicit task being run by the thread.  */
+
+struct gomp_profile_frame
+{
+  const void *fn;
+  uint64_t start, idle;
+  /* Start of the current barrier wait or of its part after the last task
+     run in it, 0 if none, and the wait so far.  */
+  uint64_t barrier_start, barrier_wait;
+  const void *barrier_site;
+  bool in_barrier;
+  uint64_t work_start;
+  unsigned long work_kind, work_chunk;
+  /* Performance counters at the start of the task and of the work
+     share.  */
+  uint64_t counters[GOMP_PERF_COUNTERS], work_counters[GOMP_PERF_COUNTERS];
+};
+
+/* A parallel region started by the thread.  */
+
+struct gomp_profile_region
+{
+  const void *team, *fn;
+  uint64_t start;
+  bool toplevel;
+};
+
+/* An explicit task being run by the thread.  */
+
+struct gomp_profile_task
+{
+  const void *task, *fn;
+  uint64_t start;
+};
+
+/* A lock followed with GOMP_PROFILE_LOCKS.  Unlike the sites, the locks
+   are in a table shared by all threads, so that the statistics of a lock
+   are in one place.  */
+
+struct gomp_profile_lock
+{
+  /* The lock, or NULL for a free entry.  */
+  const void *lock;
+  /* Call site of its first acquisition, and its gomp_tool_mutex_t.  */
+  const void *site;
+  int kind;
+  unsigned long count, contended;
+  uint64_t ticks, max;
+};
+
+struct gomp_profile_thread
+{
+  /* All the profiles, and the profiles of exited threads.  */
+  struct gomp_profile_thread *next, *next_free;
+  /* Threads that used the profile.  */
+  unsigned long nthreads;
+  unsigned int nframes, nregions, ntasks;
+  struct gomp_profile_frame frames[GOMP_PROFILE_DEPTH];
+  struct gomp_profile_region regions[GOMP_PROFILE_DEPTH];
+  struct gomp_profile_task tasks[GOMP_PROFILE_DEPTH];
+  uint64_t lock_start;
+  /* The lock waited for with GOMP_PROFILE_LOCKS.  */
+  struct gomp_profile_lock *lock;
+  /* Time of the top-level regions started by the thread.  */
+  uint64_t parallel_ticks;
+  /* Events that could not be recorded.  */
+  unsigned long lost;
+  struct gomp_profile_site sites[GOMP_PROFILE_SITES];
+};
+
+bool gomp_profile_enabled;
+static struct gomp_profile_thread *gomp_profile_threads;
+static struct gomp_profile_thread *gomp_profile_free;
+static gomp_mutex_t gomp_profile_lock;
+static uint64_t gomp_profile_start_ticks;
+static double gomp_profile_start_time;
+/* Performance counters available on any thread.  */
+static unsigned int gomp_profile_counters_mask;
+static struct gomp_profile_lock *gomp_profile_locks;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_profile (void)
+{
+  gomp_mutex_init (&gomp_profile_lock);
+}
+#endif
+
+static inline unsigned int
+gomp_profile_bucket (uint64_t ticks)
+{
+  int b = ticks ? 63 - __builtin_clzll (ticks) - GOMP_PROFILE_MIN_BUCKET : 0;
+
+  if (b < 0)
+    return 0;
+  return b < GOMP_PROFILE_BUCKETS ? b : GOMP_PROFILE_BUCKETS - 1;
+}
+
+/* Return the entry of SITE of KIND in the table SITES of SIZE entries,
+   allocating it if needed, or NULL if the table is full.  */
+
+static struct gomp_profile_site *
+gomp_profile_site (struct gomp_profile_site *sites, unsigned int size,
+		   int kind, const void *site)
+{
+  unsigned int i = ((uintptr_t) site >> 4) ^ (kind * 0x9e3779b9u);
+  unsigned int n;
+
+  i &= size - 1;
+  for (n = 0; n < size; n++, i = (i + 1) & (size - 1))
+    {
+      if (!sites[i].used)
+	{
+	  sites[i].site = site;
+	  sites[i].kind = kind;
+	  sites[i].used = true;
+	  return &sites[i];
+	}
+      if (sites[i].site == site && sites[i].kind == kind)
+	return &sites[i];
+    }
+  return NULL;
+}
+
+/* Account a duration of TICKS to SITE of KIND for PT.  */
+
+static struct gomp_profile_site *
+gomp_profile_record (struct gomp_profile_thread *pt, int kind,
+		     const void *site, uint64_t ticks)
+{
+  struct gomp_profile_site *s
+    = gomp_profile_site (pt->sites, GOMP_PROFILE_SITES, kind, site);
+
+  if (s == NULL)
+    {
+      pt->lost++;
+      return NULL;
+    }
+  s->count++;
+  s->ticks += ticks;
+  if (ticks > s->max)
+    s->max = ticks;
+  s->hist[gomp_profile_bucket (ticks)]++;
+  return s;
+}
+
+/* Read the performance counters of the calling thread into VALUES.  */
+
+static inline void
+gomp_profile_read_counters (uint64_t *values)
+{
+  unsigned int mask = gomp_perf_read (values);
+
+  if ((gomp_profile_counters_mask & mask) != mask)
+    __atomic_fetch_or (&gomp_profile_counters_mask, mask, MEMMODEL_RELAXED);
+}
+
+/* Add the increase of the performance counters since START to S.  */
+
+static void
+gomp_profile_add_counters (struct gomp_profile_site *s,
+			   const uint64_t *start)
+{
+  uint64_t now[GOMP_PERF_COUNTERS];
+  int i;
+
+  gomp_perf_read (now);
+  for (i = 0; i < GOMP_PERF_COUNTERS; i++)
+    s->counters[i] += now[i] - start[i];
+}
+
+/* Return the entry of LOCK of KIND, allocating it for its first
+   acquisition at SITE if needed, or NULL if the table is full.  */
+
+static struct gomp_profile_lock *
+gomp_profile_lock_entry (const void *lock, int kind, const void *site)
+{
+  unsigned int i = ((uintptr_t) lock >> 4) & (GOMP_PROFILE_LOCK_ENTRIES - 1);
+  unsigned int n;
+
+  for (n = 0; n < GOMP_PROFILE_LOCK_ENTRIES;
+       n++, i = (i + 1) & (GOMP_PROFILE_LOCK_ENTRIES - 1))
+    {
+      struct gomp_profile_lock *l = &gomp_profile_locks[i];
+      const void *key = __atomic_load_n (&l->lock, MEMMODEL_ACQUIRE);
+
+      if (key == NULL
+	  && __atomic_compare_exchange_n (&l->lock, &key, lock, false,
+					  MEMMODEL_ACQ_REL, MEMMODEL_ACQUIRE))
+	{
+	  l->kind = kind;
+	  l->site = site;
+	  return l;
+	}
+      if (key == lock)
+	return l;
+    }
+  return NULL;
+}
+
+/* Account an acquisition of L after a wait of TICKS.  */
+
+static void
+gomp_profile_lock_acquired (struct gomp_profile_lock *l, bool contended,
+			    uint64_t ticks)
+{
+  uint64_t max = __atomic_load_n (&l->max, MEMMODEL_RELAXED);
+
+  __atomic_fetch_add (&l->count, 1, MEMMODEL_RELAXED);
+  if (contended)
+    __atomic_fetch_add (&l->contended, 1, MEMMODEL_RELAXED);
+  __atomic_fetch_add (&l->ticks, ticks, MEMMODEL_RELAXED);
+  while (ticks > max
+	 && !__atomic_compare_exchange_n (&l->max, &max, ticks, true,
+					  MEMMODEL_RELAXED, MEMMODEL_RELAXED))
+    ;
+}
+
+static struct gomp_profile_thread *
+gomp_profile_thread (void)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_profile_thread *pt = thr->profile;
+
+  if (__builtin_expect (pt == NULL, 0))
+    {
+      gomp_mutex_lock (&gomp_profile_lock);
+      pt = gomp_profile_free;
+      if (pt != NULL)
+	gomp_profile_free = pt->next_free;
+      else
+	{
+	  pt = gomp_malloc_cleared (sizeof (*pt));
+	  pt->next = gomp_profile_threads;
+	  gomp_profile_threads = pt;
+	}
+      pt->nthreads++;
+      gomp_mutex_unlock (&gomp_profile_lock);
+      thr->profile = pt;
+      gomp_free_thread_at_exit (thr);
+    }
+  return pt;
+}
+
+/* Called when THR exits.  Its sites are only merged into the report at
+   exit, so its profile goes on the free list and the next thread to
+   start adds to it, rather than every thread of a program that keeps
+   creating threads getting a profile of its own.  */
+
+void
+gomp_profile_free_thread (struct gomp_thread *thr)
+{
+  struct gomp_profile_thread *pt = thr->profile;
+
+  if (pt == NULL)
+    return;
+  thr->profile = NULL;
+  pt->nframes = 0;
+  pt->nregions = 0;
+  pt->ntasks = 0;
+  pt->lock_start = 0;
+  pt->lock = NULL;
+  gomp_mutex_lock (&gomp_profile_lock);
+  pt->next_free = gomp_profile_free;
+  gomp_profile_free = pt;
+  gomp_mutex_unlock (&gomp_profile_lock);
+}
+
+/* Time EVENT of the tool interface, see GOMP_tool_set_callback for the
+   arguments.  */
+
+void
+gomp_profile_event (int event, const void *object, unsigned long arg0,
+		    unsigned long arg1)
+{
+  struct gomp_profile_thread *pt = gomp_profile_thread ();
+  struct gomp_profile_frame *f
+    = pt->nframes && pt->nframes <= GOMP_PROFILE_DEPTH
+      ? &pt->frames[pt->nframes - 1] : NULL;
+  uint64_t now = gomp_profile_ticks ();
+  struct gomp_profile_site *s;
+
+  switch (event)
+    {
+    case gomp_tool_event_parallel_begin:
+      if (pt->nregions < GOMP_PROFILE_DEPTH)
+	{
+	  struct gomp_profile_region *r = &pt->regions[pt->nregions];
+	  r->team = object;
+	  r->fn = (const void *) arg1;
+	  r->start = now;
+	  r->toplevel = gomp_thread ()->ts.team == NULL;
+	}
+      pt->nregions++;
+      break;
+
+    case gomp_tool_event_parallel_end:
+      if (pt->nregions == 0)
+	break;
+      if (--pt->nregions < GOMP_PROFILE_DEPTH)
+	{
+	  struct gomp_profile_region *r = &pt->regions[pt->nregions];
+	  gomp_profile_record (pt, GOMP_PROFILE_REGION, r->fn, now - r->start);
+	  if (r->toplevel)
+	    pt->parallel_ticks += now - r->start;
+	}
+      break;
+
+    case gomp_tool_event_implicit_task_begin:
+      if (pt->nframes < GOMP_PROFILE_DEPTH)
+	{
+	  f = &pt->frames[pt->nframes];
+	  memset (f, 0, sizeof (*f));
+	  f->fn = (const void *) arg1;
+	  f->start = now;
+	  if (gomp_profile_counters_var)
+	    gomp_profile_read_counters (f->counters);
+	}
+      pt->nframes++;
+      break;
+
+    case gomp_tool_event_implicit_task_end:
+      if (pt->nframes == 0)
+	break;
+      pt->nframes--;
+      if (f == NULL)
+	break;
+      /* The count of the region is kept by its master.  */
+      s = gomp_profile_site (pt->sites, GOMP_PROFILE_SITES,
+			     GOMP_PROFILE_REGION, f->fn);
+      if (s == NULL)
+	{
+	  pt->lost++;
+	  break;
+	}
+      s->aux[0] += now - f->start;
+      s->aux[1] += f->idle;
+      if (gomp_profile_counters_var)
+	gomp_profile_add_counters (s, f->counters);
+      break;
+
+    case gomp_tool_event_barrier_wait_begin:
+      if (f == NULL)
+	break;
+      f->in_barrier = true;
+      f->barrier_start = now;
+      f->barrier_wait = 0;
+      f->barrier_site = (const void *) arg0;
+      break;
+
+    case gomp_tool_event_barrier_wait_end:
+      if (f == NULL || !f->in_barrier)
+	break;
+      f->in_barrier = false;
+      if (f->barrier_start)
+	f->barrier_wait += now - f->barrier_start;
+      f->idle += f->barrier_wait;
+      if (f->barrier_site != NULL)
+	gomp_profile_record (pt, GOMP_PROFILE_BARRIER, f->barrier_site,
+			     f->barrier_wait);
+      else
+	gomp_profile_record (pt, GOMP_PROFILE_JOIN, f->fn, f->barrier_wait);
+      break;
+
+    case gomp_tool_event_task_schedule:
+      /* Tasks run while waiting in a barrier are not part of the wait.  */
+      if (f != NULL && f->in_barrier && f->barrier_start)
+	{
+	  f->barrier_wait += now - f->barrier_start;
+	  f->barrier_start = 0;
+	}
+      if (pt->ntasks < GOMP_PROFILE_DEPTH)
+	{
+	  struct gomp_profile_task *t = &pt->tasks[pt->ntasks];
+	  t->task = object;
+	  t->fn = (const void *) arg0;
+	  t->start = now;
+	}
+      pt->ntasks++;
+      break;
+
+    case gomp_tool_event_task_complete:
+      /* An untied task that got suspended is not completed by the thread
+	 that scheduled it, drop it.  */
+      while (pt->ntasks > 0)
+	{
+	  pt->ntasks--;
+	  if (pt->ntasks < GOMP_PROFILE_DEPTH
+	      && pt->tasks[pt->ntasks].task == object)
+	    {
+	      gomp_profile_record (pt, GOMP_PROFILE_TASK, (const void *) arg0,
+				   now - pt->tasks[pt->ntasks].start);
+	      break;
+	    }
+	}
+      if (f != NULL && f->in_barrier && pt->ntasks == 0)
+	f->barrier_start = now;
+      break;
+
+    case gomp_tool_event_work_begin:
+      if (f == NULL)
+	break;
+      f->work_start = now;
+      f->work_kind = arg0;
+      f->work_chunk = arg1;
+      if (gomp_profile_counters_var)
+	gomp_profile_read_counters (f->work_counters);
+      break;
+
+    case gomp_tool_event_work_end:
+      if (f == NULL || f->work_start == 0)
+	break;
+      s = gomp_profile_record (pt, GOMP_PROFILE_WORK, (const void *) arg0,
+			       now - f->work_start);
+      if (s != NULL)
+	{
+	  s->aux[0] = f->work_kind;
+	  s->aux[1] = f->work_chunk;
+	  if (gomp_profile_counters_var)
+	    gomp_profile_add_counters (s, f->work_counters);
+	}
+      f->work_start = 0;
+      break;
+
+    case gomp_tool_event_lock_wait_begin:
+      pt->lock_start = now;
+      pt->lock = NULL;
+      /* The ordered construct is not released like a lock.  */
+      if (gomp_profile_locks != NULL && arg0 != gomp_tool_mutex_ordered)
+	{
+	  pt->lock = gomp_profile_lock_entry (object, arg0,
+					      (const void *) arg1);
+	  if (pt->lock == NULL)
+	    pt->lost++;
+	}
+      break;
+
+    case gomp_tool_event_lock_wait_end:
+      if (pt->lock_start == 0)
+	break;
+      gomp_profile_record (pt, GOMP_PROFILE_LOCK + arg0 - gomp_tool_mutex_lock,
+			   (const void *) arg1, now - pt->lock_start);
+      /* The lock routines tried to take the lock before waiting.  */
+      if (pt->lock != NULL)
+	gomp_profile_lock_acquired (pt->lock, gomp_thread ()->lock_contended,
+				    now - pt->lock_start);
+      pt->lock_start = 0;
+      pt->lock = NULL;
+      break;
+    }
+}
+
+/* Start profiling.  */
+
+void
+gomp_init_profile (void)
+{
+  gomp_profile_start_time = omp_get_wtime ();
+  gomp_profile_start_ticks = gomp_profile_ticks ();
+  if (gomp_profile_locks_var)
+    gomp_profile_locks
+      = gomp_malloc_cleared (GOMP_PROFILE_LOCK_ENTRIES
+			     * sizeof (*gomp_profile_locks));
+  gomp_profile_enabled = true;
+  gomp_tool_enabled = true;
+}
+
+
+/* Writing the summary.  */
+
+static double gomp_profile_tick_ns;
+
+/* Print the time of TICKS to F in a unit fitting its magnitude.  */
+
+static void
+gomp_profile_print_time (FILE *f, double ticks)
+{
+  double ns = ticks * gomp_profile_tick_ns;
+
+  if (ns < 1e3)
+    fprintf (f, "%8.0fns", ns);
+  else if (ns < 1e6)
+    fprintf (f, "%8.2fus", ns / 1e3);
+  else if (ns < 1e9)
+    fprintf (f, "%8.2fms", ns / 1e6);
+  else
+    fprintf (f, "%8.3fs ", ns / 1e9);
+}
+
+/* Write the name of the function or call site at ADDR to BUF of SIZE
+   bytes, as a symbol or object file and offset where possible.  */
+
+void
+gomp_profile_symbol (char *buf, size_t size, const void *addr)
+{
+#ifdef HAVE_DLFCN_H
+  Dl_info info;
+
+  if (addr != NULL && dladdr (addr, &info) != 0)
+    {
+      if (info.dli_sname != NULL)
+	{
+	  if (addr == info.dli_saddr)
+	    snprintf (buf, size, "%s", info.dli_sname);
+	  else
+	    snprintf (buf, size, "%s+%#lx", info.dli_sname,
+		      (unsigned long) ((const char *) addr
+				       - (const char *) info.dli_saddr));
+	  return;
+	}
+      if (info.dli_fname != NULL)
+	{
+	  const char *base = strrchr (info.dli_fname, '/');
+	  snprintf (buf, size, "%s+%#lx", base ? base + 1 : info.dli_fname,
+		    (unsigned long) ((const char *) addr
+				     - (const char *) info.dli_fbase));
+	  return;
+	}
+    }
+#endif
+  snprintf (buf, size, "%p", addr);
+}
+
+static void
+gomp_profile_print_site (FILE *f, const void *addr)
+{
+  char buf[256];
+
+  gomp_profile_symbol (buf, sizeof (buf), addr);
+  fprintf (f, "  %s", buf);
+}
+
+static void
+gomp_profile_print_hist (FILE *f, const struct gomp_profile_site *s)
+{
+  unsigned int i;
+
+  fputs ("     ", f);
+  for (i = 0; i < GOMP_PROFILE_BUCKETS; i++)
+    if (s->hist[i])
+      {
+	/* Print the upper bound of the bucket, or the lower bound of the
+	   last one.  */
+	bool last = i + 1 == GOMP_PROFILE_BUCKETS;
+
+	fputs (last ? " >=" : " <", f);
+	gomp_profile_print_time (f, (double) (1UL << (i + !last
+						     + GOMP_PROFILE_MIN_BUCKET)));
+	fprintf (f, ":%u", s->hist[i]);
+      }
+  fputc ('\n', f);
+}
+
+static int
+gomp_profile_compare (const void *a, const void *b)
+{
+  const struct gomp_profile_site *x = *(const struct gomp_profile_site **) a;
+  const struct gomp_profile_site *y = *(const struct gomp_profile_site **) b;
+
+  return x->ticks < y->ticks ? 1 : x->ticks > y->ticks ? -1 : 0;
+}
+
+/* Print the table of the sites of the kinds FIRST to LAST in SITES, most
+   costly first, under TITLE.  */
+
+static void
+gomp_profile_print_table (FILE *f, struct gomp_profile_site *sites,
+			  int first, int last, const char *title)
+{
+  static const char *const mutex_names[] =
+    { "lock", "nest lock", "critical", "ordered", "atomic" };
+  static const char *const sched_names[] =
+    { "sections", "static", "dynamic", "guided", "binlpt", "srr", "auto" };
+  struct gomp_profile_site **list;
+  unsigned int i, n = 0;
+
+  list = gomp_malloc (GOMP_PROFILE_MERGED_SITES * sizeof (*list));
+  for (i = 0; i < GOMP_PROFILE_MERGED_SITES; i++)
+    if (sites[i].count && sites[i].kind >= first && sites[i].kind <= last)
+      list[n++] = &sites[i];
+  if (n == 0)
+    {
+      free (list);
+      return;
+    }
+  qsort (list, n, sizeof (*list), gomp_profile_compare);
+
+  fprintf (f, "\n%s:\n", title);
+  for (i = 0; i < n && i < GOMP_PROFILE_TOP; i++)
+    {
+      struct gomp_profile_site *s = list[i];
+
+      fprintf (f, "  %10lu", s->count);
+      gomp_profile_print_time (f, s->ticks);
+      gomp_profile_print_time (f, (double) s->ticks / s->count);
+      gomp_profile_print_time (f, s->max);
+      switch (s->kind)
+	{
+	case GOMP_PROFILE_REGION:
+	  fprintf (f, "  idle %5.1f%%",
+		   s->aux[0] ? 100.0 * s->aux[1] / s->aux[0] : 0.0);
+	  break;
+	case GOMP_PROFILE_JOIN:
+	  fputs ("  end of", f);
+	  break;
+	case GOMP_PROFILE_LOCK:
+	case GOMP_PROFILE_NEST_LOCK:
+	case GOMP_PROFILE_CRITICAL:
+	case GOMP_PROFILE_ORDERED:
+	case GOMP_PROFILE_ATOMIC:
+	  fprintf (f, "  %s", mutex_names[s->kind - GOMP_PROFILE_LOCK]);
+	  break;
+	case GOMP_PROFILE_WORK:
+	  if (s->aux[0] < sizeof (sched_names) / sizeof (sched_names[0]))
+	    fprintf (f, "  %s,%lu", sched_names[s->aux[0]],
+		     (unsigned long) s->aux[1]);
+	  break;
+	}
+      gomp_profile_print_site (f, s->site);
+      fputc ('\n', f);
+      if (s->kind != GOMP_PROFILE_REGION && s->kind != GOMP_PROFILE_TASK
+	  && s->kind != GOMP_PROFILE_WORK)
+	gomp_profile_print_hist (f, s);
+    }
+  if (n > GOMP_PROFILE_TOP)
+    fprintf (f, "  ... %u more\n", n - GOMP_PROFILE_TOP);
+  free (list);
+}
+
+/* Print the performance counters of the regions and work shares in SITES,
+   most costly first.  */
+
+static void
+gomp_profile_print_counters (FILE *f, struct gomp_profile_site *sites)
+{
+  static const char *const names[GOMP_PERF_COUNTERS] =
+    { "cycles", "instructions", "cache misses", "task clock",
+      "switches" };
+  unsigned int mask = gomp_profile_counters_mask;
+  struct gomp_profile_site **list;
+  unsigned int i, j, n = 0;
+
+  list = gomp_malloc (GOMP_PROFILE_MERGED_SITES * sizeof (*list));
+  for (i = 0; i < GOMP_PROFILE_MERGED_SITES; i++)
+    if (sites[i].count && (sites[i].kind == GOMP_PROFILE_REGION
+			   || sites[i].kind == GOMP_PROFILE_WORK))
+      list[n++] = &sites[i];
+  qsort (list, n, sizeof (*list), gomp_profile_compare);
+
+  fputs ("\nPerformance counters:\n  ", f);
+  for (j = 0; j < GOMP_PERF_COUNTERS; j++)
+    if (mask & (1U << j))
+      fprintf (f, " %14s", names[j]);
+  if ((mask & 3) == 3)
+    fputs ("    IPC", f);
+  fputc ('\n', f);
+  for (i = 0; i < n && i < GOMP_PROFILE_TOP; i++)
+    {
+      struct gomp_profile_site *s = list[i];
+
+      fputs ("  ", f);
+      for (j = 0; j < GOMP_PERF_COUNTERS; j++)
+	if (mask & (1U << j))
+	  fprintf (f, " %14llu", (unsigned long long) s->counters[j]);
+      if ((mask & 3) == 3)
+	fprintf (f, " %6.2f", s->counters[0]
+			      ? (double) s->counters[1] / s->counters[0] : 0.0);
+      fputs (s->kind == GOMP_PROFILE_REGION ? "  region" : "  work  ", f);
+      gomp_profile_print_site (f, s->site);
+      fputc ('\n', f);
+    }
+  free (list);
+}
+
+static int
+gomp_profile_compare_locks (const void *a, const void *b)
+{
+  const struct gomp_profile_lock *x = *(const struct gomp_profile_lock **) a;
+  const struct gomp_profile_lock *y = *(const struct gomp_profile_lock **) b;
+
+  return x->ticks < y->ticks ? 1 : x->ticks > y->ticks ? -1 : 0;
+}
+
+/* Print the locks followed with GOMP_PROFILE_LOCKS, the longest waited
+   for first.  */
+
+static void
+gomp_profile_print_locks (FILE *f)
+{
+  static const char prefix[] = ".gomp_critical_user_";
+  struct gomp_profile_lock **list;
+  unsigned int i, n = 0;
+  char buf[256];
+
+  list = gomp_malloc (GOMP_PROFILE_LOCK_ENTRIES * sizeof (*list));
+  for (i = 0; i < GOMP_PROFILE_LOCK_ENTRIES; i++)
+    if (gomp_profile_locks[i].count)
+      list[n++] = &gomp_profile_locks[i];
+  if (n == 0)
+    {
+      free (list);
+      return;
+    }
+  qsort (list, n, sizeof (*list), gomp_profile_compare_locks);
+
+  fputs ("\nLocks:\n    acquired  contended     total       max\n", f);
+  for (i = 0; i < n && i < GOMP_PROFILE_TOP; i++)
+    {
+      struct gomp_profile_lock *l = list[i];
+
+      fprintf (f, "  %10lu %10lu", l->count, l->contended);
+      gomp_profile_print_time (f, l->ticks);
+      gomp_profile_print_time (f, l->max);
+      switch (l->kind)
+	{
+	case gomp_tool_mutex_critical:
+	  /* Named critical constructs are identified by the variable the
+	     compiler made for their name.  */
+	  if (l->lock == gomp_critical_default_lock)
+	    fputs ("  critical", f);
+	  else
+	    {
+	      gomp_profile_symbol (buf, sizeof (buf), l->lock);
+	      fprintf (f, "  critical %s",
+		       strncmp (buf, prefix, sizeof (prefix) - 1) == 0
+		       ? buf + sizeof (prefix) - 1 : buf);
+	    }
+	  break;
+	case gomp_tool_mutex_atomic:
+	  fputs ("  atomic", f);
+	  break;
+	default:
+	  fprintf (f, "  lock %p", l->lock);
+	  break;
+	}
+      gomp_profile_symbol (buf, sizeof (buf), l->site);
+      fprintf (f, " first at %s\n", buf);
+    }
+  if (n > GOMP_PROFILE_TOP)
+    fprintf (f, "  ... %u more\n", n - GOMP_PROFILE_TOP);
+  free (list);
+}
+
+/* Open the file named by GOMP_PROFILE, in which %p stands for the process
+   ID, or return stderr for TRUE.  */
+
+static FILE *
+gomp_profile_open (void)
+{
+  const char *p = strstr (gomp_profile_var, "%p");
+  char *name;
+  FILE *f;
+
+  if (strcasecmp (gomp_profile_var, "true") == 0)
+    return stderr;
+  name = gomp_alloca (strlen (gomp_profile_var) + 3 * sizeof (pid_t));
+  if (p != NULL)
+    sprintf (name, "%.*s%lu%s", (int) (p - gomp_profile_var),
+	     gomp_profile_var, (unsigned long) getpid (), p + 2);
+  else
+    strcpy (name, gomp_profile_var);
+  f = fopen (name, "w");
+  if (f == NULL)
+    {
+      gomp_error ("Cannot open GOMP_PROFILE file %s, using stderr", name);
+      return stderr;
+    }
+  return f;
+}
+
+/* Merge the tables of all threads and write the summary.  */
+
+static void __attribute__((destructor))
+gomp_profile_fini (void)
+{
+  struct gomp_profile_site *sites;
+  struct gomp_profile_thread *pt;
+  uint64_t elapsed, parallel = 0;
+  unsigned long lost = 0, nthreads = 0;
+  unsigned int i, j;
+  FILE *f;
+
+  if (!gomp_profile_enabled)
+    return;
+  gomp_profile_enabled = false;
+
+  elapsed = gomp_profile_ticks () - gomp_profile_start_ticks;
+  gomp_profile_tick_ns = elapsed
+			 ? (omp_get_wtime () - gomp_profile_start_time) * 1e9
+			   / elapsed
+			 : 1.0;
+
+  sites = gomp_malloc_cleared (GOMP_PROFILE_MERGED_SITES * sizeof (*sites));
+  gomp_mutex_lock (&gomp_profile_lock);
+  for (pt = gomp_profile_threads; pt != NULL; pt = pt->next)
+    {
+      nthreads += pt->nthreads;
+      parallel += pt->parallel_ticks;
+      lost += pt->lost;
+      for (i = 0; i < GOMP_PROFILE_SITES; i++)
+	{
+	  struct gomp_profile_site *from = &pt->sites[i], *to;
+
+	  if (!from->used)
+	    continue;
+	  to = gomp_profile_site (sites, GOMP_PROFILE_MERGED_SITES,
+				  from->kind, from->site);
+	  if (to == NULL)
+	    {
+	      lost += from->count;
+	      continue;
+	    }
+	  to->count += from->count;
+	  to->ticks += from->ticks;
+	  if (from->max > to->max)
+	    to->max = from->max;
+	  if (from->kind == GOMP_PROFILE_WORK)
+	    {
+	      to->aux[0] = from->aux[0];
+	      to->aux[1] = from->aux[1];
+	    }
+	  else
+	    {
+	      to->aux[0] += from->aux[0];
+	      to->aux[1] += from->aux[1];
+	    }
+	  for (j = 0; j < GOMP_PROFILE_BUCKETS; j++)
+	    to->hist[j] += from->hist[j];
+	  for (j = 0; j < GOMP_PERF_COUNTERS; j++)
+	    to->counters[j] += from->counters[j];
+	}
+    }
+  gomp_mutex_unlock (&gomp_profile_lock);
+
+  /* Top-level regions of several threads can overlap.  */
+  if (parallel > elapsed)
+    parallel = elapsed;
+
+  f = gomp_profile_open ();
+  fprintf (f, "libgomp profile of process %lu, %lu threads\n",
+	   (unsigned long) getpid (), nthreads);
+  fputs ("  elapsed ", f);
+  gomp_profile_print_time (f, elapsed);
+  fputs (", serial ", f);
+  gomp_profile_print_time (f, elapsed - parallel);
+  fprintf (f, " (%.1f%%), parallel ",
+	   elapsed ? 100.0 * (elapsed - parallel) / elapsed : 0.0);
+  gomp_profile_print_time (f, parallel);
+  fprintf (f, " (%.1f%%)\n", elapsed ? 100.0 * parallel / elapsed : 0.0);
+  if (lost)
+    fprintf (f, "  %lu events not recorded\n", lost);
+  fputs ("\n       count     total   average       max\n", f);
+
+  gomp_profile_print_table (f, sites, GOMP_PROFILE_REGION,
+			    GOMP_PROFILE_REGION, "Parallel regions");
+  gomp_profile_print_table (f, sites, GOMP_PROFILE_BARRIER, GOMP_PROFILE_JOIN,
+			    "Barrier waits");
+  gomp_profile_print_table (f, sites, GOMP_PROFILE_LOCK, GOMP_PROFILE_ATOMIC,
+			    "Lock waits");
+  gomp_profile_print_table (f, sites, GOMP_PROFILE_TASK, GOMP_PROFILE_TASK,
+			    "Tasks");
+  gomp_profile_print_table (f, sites, GOMP_PROFILE_WORK, GOMP_PROFILE_WORK,
+			    "Loops and sections");
+  if (gomp_profile_counters_mask)
+    gomp_profile_print_counters (f, sites);
+  if (gomp_profile_locks != NULL)
+    gomp_profile_print_locks (f);
+  if (f != stderr)
+    fclose (f);
+  free (sites);
+}
+
+
+/* The public API.  */
+
+/* Store in *VALUE the count of COUNTER for the calling thread since its
+   counters were first read.  Return 0 on success, or -1 if the counter
+   is invalid or unavailable.  */
+
+int
+GOMP_get_perf_counter (gomp_perf_counter_t counter,
+		       unsigned long long *value)
+{
+  uint64_t values[GOMP_PERF_COUNTERS];
+  unsigned int index = counter - gomp_perf_cycles;
+
+  if (index >= GOMP_PERF_COUNTERS
+      || !(gomp_perf_read (values) & (1U << index)))
+    return -1;
+  *value = values[index];
+  return 0;
+}
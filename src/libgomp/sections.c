@@ -76,6 +76,7 @@ GOMP_sections_start (unsigned count)
       gomp_sections_init (thr->ts.work_share, count);
       gomp_work_share_init_done ();
     }
+  gomp_tool_event (gomp_tool_event_work_begin, thr->ts.work_share, 0, count);
 
 #ifdef HAVE_SYNC_BUILTINS
   if (gomp_iter_dynamic_next (&s, &e))
@@ -136,9 +137,11 @@ GOMP_parallel_sections_start (void (*fn) (void *), void *data,
 {
   struct gomp_team *team;
 
-  num_threads = gomp_resolve_num_threads (num_threads, count);
+  num_threads = gomp_resolve_num_threads (num_threads, count, fn);
   team = gomp_new_team (num_threads);
   gomp_sections_init (&team->work_shares[0], count);
+  team->tool_work_kind = 0;
+  team->tool_work_chunk = count;
   gomp_team_start (fn, data, num_threads, 0, team);
 }
 
@@ -150,9 +153,11 @@ GOMP_parallel_sections (void (*fn) (void *), void *data,
 {
   struct gomp_team *team;
 
-  num_threads = gomp_resolve_num_threads (num_threads, count);
+  num_threads = gomp_resolve_num_threads (num_threads, count, fn);
   team = gomp_new_team (num_threads);
   gomp_sections_init (&team->work_shares[0], count);
+  team->tool_work_kind = 0;
+  team->tool_work_chunk = count;
   gomp_team_start (fn, data, num_threads, flags, team);
   fn (data);
   GOMP_parallel_end ();
@@ -165,17 +170,23 @@ GOMP_parallel_sections (void (*fn) (void *), void *data,
 void
 GOMP_sections_end (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), true);
   gomp_work_share_end ();
 }
 
 bool
 GOMP_sections_end_cancel (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), true);
   return gomp_work_share_end_cancel ();
 }
 
 void
 GOMP_sections_end_nowait (void)
 {
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_work_end (__builtin_return_address (0), false);
   gomp_work_share_end_nowait ();
 }
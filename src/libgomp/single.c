@@ -76,6 +76,8 @@ GOMP_single_copy_start (void)
     }
   else
     {
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	thr->tool_site = __builtin_return_address (0);
       gomp_team_barrier_wait (&thr->ts.team->barrier);
 
       ret = thr->ts.work_share->copyprivate;
@@ -97,6 +99,8 @@ GOMP_single_copy_end (void *data)
   if (team != NULL)
     {
       thr->ts.work_share->copyprivate = data;
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	thr->tool_site = __builtin_return_address (0);
       gomp_team_barrier_wait (&team->barrier);
     }
 
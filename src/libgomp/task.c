@@ -26,6 +26,8 @@
    creation and termination.  */
 
 #include "libgomp.h"
+#include "context.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -57,6 +59,224 @@ htab_eq (hash_entry_type x, hash_entry_type y)
   return x->addr == y->addr;
 }
 
+/* Return the ready queue bucket for tasks of priority PRIORITY.  */
+
+static inline unsigned int
+gomp_task_priority_bucket (int priority)
+{
+  if (gomp_max_task_priority_var < GOMP_TASK_PRIORITY_BUCKETS)
+    return priority;
+  return ((unsigned long long) priority * GOMP_TASK_PRIORITY_BUCKETS
+	  / ((unsigned long long) gomp_max_task_priority_var + 1));
+}
+
+/* Return true if task A should be started before task B: it has a
+   higher priority or, at equal priority, a higher cost estimate, so that
+   the longest tasks are started first and don't end up running alone at
+   the end of a taskwait or taskgroup.  */
+
+static inline bool
+gomp_task_before_p (struct gomp_task *a, struct gomp_task *b)
+{
+  return (a->priority > b->priority
+	  || (a->priority == b->priority && a->cost > b->cost));
+}
+
+/* Insert TASK into the bucket of QUEUE matching its priority.  The
+   bucket is searched from its tail, so tasks without a cost estimate
+   are appended in constant time.  At most GOMP_TASK_INSERT_WALK tasks
+   are skipped, so that queueing many costed tasks in increasing order
+   stays linear; past that the order is only approximate.  */
+
+static inline void
+gomp_task_queue_insert (struct gomp_task_queue *queue, struct gomp_task *task)
+{
+  unsigned int bucket = gomp_task_priority_bucket (task->priority);
+  struct gomp_task *head = queue->buckets[bucket];
+
+  if (gomp_task_cutoff_adaptive_var)
+    queue->count++;
+
+  if (queue->nonempty & (1U << bucket))
+    {
+      struct gomp_task *pos = head->prev_queue;
+      unsigned int walk = GOMP_TASK_INSERT_WALK;
+      while (pos != head && gomp_task_before_p (task, pos) && --walk)
+	pos = pos->prev_queue;
+      if (pos == head && gomp_task_before_p (task, pos))
+	{
+	  /* TASK becomes the new head, i.e. it follows the tail.  */
+	  pos = head->prev_queue;
+	  queue->buckets[bucket] = task;
+	}
+      task->prev_queue = pos;
+      task->next_queue = pos->next_queue;
+      task->next_queue->prev_queue = task;
+      task->prev_queue->next_queue = task;
+    }
+  else
+    {
+      task->next_queue = task;
+      task->prev_queue = task;
+      queue->buckets[bucket] = task;
+      queue->nonempty |= 1U << bucket;
+    }
+}
+
+/* Unlink TASK from QUEUE.  */
+
+static inline void
+gomp_task_queue_remove (struct gomp_task_queue *queue, struct gomp_task *task)
+{
+  unsigned int bucket = gomp_task_priority_bucket (task->priority);
+
+  if (gomp_task_cutoff_adaptive_var)
+    queue->count--;
+  task->prev_queue->next_queue = task->next_queue;
+  task->next_queue->prev_queue = task->prev_queue;
+  if (queue->buckets[bucket] == task)
+    {
+      if (task->next_queue != task)
+	queue->buckets[bucket] = task->next_queue;
+      else
+	queue->nonempty &= ~(1U << bucket);
+    }
+}
+
+/* Return the oldest task of the highest priority in QUEUE, or NULL if
+   QUEUE is empty.  */
+
+static inline struct gomp_task *
+gomp_task_queue_first (struct gomp_task_queue *queue)
+{
+  if (queue->nonempty == 0)
+    return NULL;
+  return queue->buckets[31 - __builtin_clz (queue->nonempty)];
+}
+
+/* Return the ready queue of TEAM that TASK belongs in: that of its place
+   if it has a place hint, else the shared one.  */
+
+static inline struct gomp_task_queue *
+gomp_task_queue_for (struct gomp_team *team, struct gomp_task *task)
+{
+  if (task->place == 0)
+    return &team->task_queue;
+  if (team->place_queues == NULL)
+    __atomic_store_n (&team->place_queues,
+		      gomp_malloc_cleared (gomp_places_list_len
+					   * sizeof (struct gomp_task_queue)),
+		      MEMMODEL_RELEASE);
+  return &team->place_queues[task->place - 1];
+}
+
+/* Return the task THR should run next from the ready queues of TEAM, or
+   NULL if they are all empty.  The queue of the place of THR and the
+   shared one are served first, by priority.  Only once both are empty,
+   tasks are stolen from the queues of the other places, first from
+   those on the NUMA node of the place of THR according to the topology
+   snapshot, then from the rest, each time starting with the places
+   following that of THR, which are usually the nearest.  */
+
+static inline struct gomp_task *
+gomp_task_queue_next (struct gomp_team *team, struct gomp_thread *thr)
+{
+  struct gomp_task *task = gomp_task_queue_first (&team->task_queue);
+  struct gomp_task *local;
+  unsigned long i, p, n = gomp_places_list_len;
+  int node, pass;
+
+  if (team->place_queues == NULL)
+    return task;
+  if (thr->place)
+    {
+      local = gomp_task_queue_first (&team->place_queues[thr->place - 1]);
+      if (local && (task == NULL || local->priority >= task->priority))
+	return local;
+    }
+  if (task || team->task_queued_count == 0)
+    return task;
+  node = thr->place ? gomp_affinity_place_node (thr->place - 1) : -1;
+  for (pass = node == -1; pass < 2; pass++)
+    for (i = 0; i < n; i++)
+      {
+	p = (thr->place + i) % n;
+	if (pass == 0 && gomp_affinity_place_node (p) != node)
+	  continue;
+	task = gomp_task_queue_first (&team->place_queues[p]);
+	if (task)
+	  return task;
+      }
+  return NULL;
+}
+
+/* Link TASK into the children list of PARENT.  Waiting children are
+   kept at the front of the list in gomp_task_before_p order, newest
+   first among equal ones, so that GOMP_taskwait, which only looks at the
+   first child, picks the most urgent one.  Like in the ready queue, the
+   search is bounded by GOMP_TASK_INSERT_WALK.  */
+
+static inline void
+gomp_task_insert_child (struct gomp_task *parent, struct gomp_task *task)
+{
+  struct gomp_task *pos = parent->children;
+  unsigned int walk = GOMP_TASK_INSERT_WALK;
+
+  if (pos == NULL)
+    {
+      task->next_child = task;
+      task->prev_child = task;
+      parent->children = task;
+      return;
+    }
+  while (pos->kind == GOMP_TASK_WAITING && gomp_task_before_p (pos, task)
+	 && --walk)
+    {
+      pos = pos->next_child;
+      if (pos == parent->children)
+	break;
+    }
+  task->next_child = pos;
+  task->prev_child = pos->prev_child;
+  task->next_child->prev_child = task;
+  task->prev_child->next_child = task;
+  if (pos == parent->children
+      && (pos->kind != GOMP_TASK_WAITING || !gomp_task_before_p (pos, task)))
+    parent->children = task;
+}
+
+/* Likewise for the children list of TASKGROUP.  */
+
+static inline void
+gomp_task_insert_taskgroup (struct gomp_taskgroup *taskgroup,
+			    struct gomp_task *task)
+{
+  struct gomp_task *pos = taskgroup->children;
+  unsigned int walk = GOMP_TASK_INSERT_WALK;
+
+  if (pos == NULL)
+    {
+      task->next_taskgroup = task;
+      task->prev_taskgroup = task;
+      taskgroup->children = task;
+      return;
+    }
+  while (pos->kind == GOMP_TASK_WAITING && gomp_task_before_p (pos, task)
+	 && --walk)
+    {
+      pos = pos->next_taskgroup;
+      if (pos == taskgroup->children)
+	break;
+    }
+  task->next_taskgroup = pos;
+  task->prev_taskgroup = pos->prev_taskgroup;
+  task->next_taskgroup->prev_taskgroup = task;
+  task->prev_taskgroup->next_taskgroup = task;
+  if (pos == taskgroup->children
+      && (pos->kind != GOMP_TASK_WAITING || !gomp_task_before_p (pos, task)))
+    taskgroup->children = task;
+}
+
 /* Create a new task data structure.  */
 
 void
@@ -66,8 +286,14 @@ gomp_init_task (struct gomp_task *task, struct gomp_task *parent_task,
   task->parent = parent_task;
   task->icv = *prev_icv;
   task->kind = GOMP_TASK_IMPLICIT;
+  task->priority = 0;
+  task->cost = 0;
+  task->place = 0;
+  task->depth = parent_task ? parent_task->depth + 1 : 0;
   task->in_taskwait = false;
   task->in_tied_task = false;
+  task->untied = false;
+  task->suspended = false;
   task->final_task = false;
   task->copy_ctors_done = false;
   task->children = NULL;
@@ -75,9 +301,26 @@ gomp_init_task (struct gomp_task *task, struct gomp_task *parent_task,
   task->dependers = NULL;
   task->depend_hash = NULL;
   task->depend_count = 0;
+  task->batch = NULL;
+  task->context = NULL;
+  task->detach = false;
+  task->detach_team = NULL;
   gomp_sem_init (&task->taskwait_sem, 0);
 }
 
+/* Release the memory of a finished deferred TASK.  */
+
+static inline void
+gomp_free_task (struct gomp_task *task)
+{
+  gomp_finish_task (task);
+  if (task->batch == NULL)
+    free (task);
+  else if (__atomic_sub_fetch (&task->batch->refcount, 1,
+			       MEMMODEL_ACQ_REL) == 0)
+    free (task->batch);
+}
+
 /* Clean up a task, after completing it.  */
 
 void
@@ -104,17 +347,173 @@ gomp_clear_parent (struct gomp_task *children)
     while (task != children);
 }
 
+/* Return true if a task created now by THR should be run undeferred
+   because its team already has enough queued work.  Besides the hard
+   limit on the number of tasks, with the adaptive policy a task is
+   inlined once the ready queue it would join has GOMP_TASK_CUTOFF's
+   QUEUE tasks waiting per thread of the team, or QUEUE tasks if it is
+   the queue of a place, provided it is nested at least DEPTH tasks deep
+   or deferred tasks have on average been shorter than NS nanoseconds,
+   i.e. too short to amortize queueing them.  The counters are read
+   without the task_lock; a stale value only makes the heuristic
+   slightly off.  */
+
+static inline bool
+gomp_task_cutoff_p (struct gomp_thread *thr)
+{
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_task *parent = thr->task;
+  struct gomp_task_queue *queues;
+  unsigned long avg_ns, queued, limit;
+
+  if (team->task_count > 64 * team->nthreads)
+    return true;
+  if (!gomp_task_cutoff_adaptive_var)
+    return false;
+  queues = __atomic_load_n (&team->place_queues, MEMMODEL_ACQUIRE);
+  if (thr->task_place == 0 || queues == NULL)
+    {
+      queued = __atomic_load_n (&team->task_queue.count, MEMMODEL_RELAXED);
+      limit = gomp_task_cutoff_queue_var * team->nthreads;
+    }
+  else
+    {
+      queued = __atomic_load_n (&queues[thr->task_place - 1].count,
+				MEMMODEL_RELAXED);
+      limit = gomp_task_cutoff_queue_var;
+    }
+  if (queued < limit)
+    return false;
+  if (parent && parent->depth + 1 >= gomp_task_cutoff_depth_var)
+    return true;
+  avg_ns = __atomic_load_n (&team->task_avg_ns, MEMMODEL_RELAXED);
+  return avg_ns != 0 && avg_ns < gomp_task_cutoff_ns_var;
+}
+
+#ifdef GOMP_HAVE_TASK_CONTEXT
+/* Entry point of the context of an untied task.  */
+
+static void
+gomp_task_context_entry (void *data)
+{
+  struct gomp_task *task = data;
+
+  task->fn (task->fn_data);
+  task->context->done = true;
+  gomp_context_switch (&task->context->sp, task->context->caller_sp);
+  __builtin_unreachable ();
+}
+
+/* Run untied TASK in its own context, starting it there if it has not
+   run yet and resuming it otherwise.  Return true once TASK has finished
+   and false if it got suspended again, see gomp_task_suspend.  */
+
+static bool
+gomp_task_run_untied (struct gomp_task *task)
+{
+  if (task->context == NULL)
+    task->context = gomp_context_new (gomp_task_context_entry, task);
+  gomp_context_switch (&task->context->caller_sp, task->context->sp);
+  if (!task->context->done)
+    return false;
+  gomp_context_free (task->context);
+  task->context = NULL;
+  return true;
+}
+
+/* Return the gomp_thread of the calling thread.  Code that has been
+   suspended may be resumed by another thread of the team, so the address
+   must not be reused from before the context switch.  */
+
+static struct gomp_thread * __attribute__((noinline))
+gomp_thread_after_switch (void)
+{
+  __asm__ volatile ("" : : : "memory");
+  return gomp_thread ();
+}
+
+/* Suspend the calling untied TASK, which holds team->task_lock, giving
+   its thread back to the scheduling loop that ran it.  That loop sees
+   gomp_task_run_fn return false and continues with the lock still held;
+   TASK is resumed by whichever thread picks it up once gomp_task_requeue
+   has queued it again.  Return the gomp_thread of that thread.  */
+
+static struct gomp_thread *
+gomp_task_suspend (struct gomp_task *task)
+{
+  task->suspended = true;
+  gomp_context_switch (&task->context->sp, task->context->caller_sp);
+  return gomp_thread_after_switch ();
+}
+#endif
+
+/* Run the body of deferred TASK, timing it for the adaptive cutoff.
+   The time of deferred tasks that the calling thread runs while in TASK,
+   e.g. in a taskwait, is not counted, so that a task that mostly waits
+   for its children doesn't look long.  Return false if TASK is untied
+   and got suspended before finishing, in which case team->task_lock is
+   held.  */
+
+static inline bool
+gomp_task_run_fn (struct gomp_team *team, struct gomp_task *task)
+{
+  struct gomp_thread *thr;
+  double start;
+  unsigned long ns, outer_ns, nested_ns, avg_ns;
+
+  gomp_tool_event (gomp_tool_event_task_schedule, task,
+		   (unsigned long) task->fn, 0);
+#ifdef GOMP_HAVE_TASK_CONTEXT
+  if (task->untied)
+    {
+      if (!gomp_task_run_untied (task))
+	return false;
+    }
+  else
+#endif
+  if (!gomp_task_cutoff_adaptive_var)
+    task->fn (task->fn_data);
+  else
+    {
+      thr = gomp_thread ();
+      outer_ns = thr->task_nested_ns;
+      thr->task_nested_ns = 0;
+      start = omp_get_wtime ();
+      task->fn (task->fn_data);
+      ns = (omp_get_wtime () - start) * 1e9;
+      nested_ns = thr->task_nested_ns;
+      thr->task_nested_ns = outer_ns + ns;
+      ns = ns > nested_ns ? ns - nested_ns : 0;
+      avg_ns = __atomic_load_n (&team->task_avg_ns, MEMMODEL_RELAXED);
+      avg_ns = avg_ns ? avg_ns - avg_ns / 8 + ns / 8 : ns;
+      __atomic_store_n (&team->task_avg_ns, avg_ns ? avg_ns : 1,
+			MEMMODEL_RELAXED);
+    }
+  gomp_tool_event (gomp_tool_event_task_complete, task,
+		   (unsigned long) task->fn, 0);
+  return true;
+}
+
 /* Called when encountering an explicit task directive.  If IF_CLAUSE is
    false, then we must not delay in executing the task.  If UNTIED is true,
-   then the task may be executed by any member of the team.  */
+   then the task may be executed by any member of the team.  If
+   GOMP_TASK_FLAG_DETACH is set in FLAGS, the event of the task is stored
+   to *DETACH and to the first field of DATA.  */
 
 void
 GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	   long arg_size, long arg_align, bool if_clause, unsigned flags,
-	   void **depend)
+	   void **depend, int priority, void *detach)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
+  unsigned long cost = thr->task_cost;
+  unsigned int place = thr->task_place;
+
+  /* The cost and place hints only apply to the first task created after
+     them.  */
+  thr->task_cost = 0;
+  thr->task_place = 0;
 
 #ifdef HAVE_BROKEN_POSIX_SEMAPHORES
   /* If pthread_mutex_* is used for omp_*lock*, then each task must be
@@ -127,15 +526,24 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
     flags &= ~1;
 #endif
 
+  /* Callers compiled without support for the priority clause don't
+     pass PRIORITY at all.  */
+  if ((flags & GOMP_TASK_FLAG_PRIORITY) == 0 || priority < 0)
+    priority = 0;
+  else if (priority > gomp_max_task_priority_var)
+    priority = gomp_max_task_priority_var;
+
   /* If parallel or taskgroup has been cancelled, don't start new tasks.  */
   if (team
       && (gomp_team_barrier_cancelled (&team->barrier)
 	  || (thr->task->taskgroup && thr->task->taskgroup->cancelled)))
     return;
 
+  /* A detached task is never inlined by the cutoff, as the event may
+     only get fulfilled by tasks its creator goes on to create.  */
   if (!if_clause || team == NULL
       || (thr->task && thr->task->final_task)
-      || team->task_count > 64 * team->nthreads)
+      || ((flags & GOMP_TASK_FLAG_DETACH) == 0 && gomp_task_cutoff_p (thr)))
     {
       struct gomp_task task;
 
@@ -179,7 +587,19 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	  task.in_tied_task = thr->task->in_tied_task;
 	  task.taskgroup = thr->task->taskgroup;
 	}
+      if (__builtin_expect (flags & GOMP_TASK_FLAG_DETACH, 0))
+	{
+	  task.detach = true;
+	  gomp_sem_init (&task.completion_sem, 0);
+	  *(void **) detach = &task;
+	  if (data)
+	    *(void **) data = &task;
+	}
       thr->task = &task;
+      gomp_tool_event (gomp_tool_event_task_create, &task, (unsigned long) fn,
+		       0);
+      gomp_tool_event (gomp_tool_event_task_schedule, &task,
+		       (unsigned long) fn, 0);
       if (__builtin_expect (cpyfn != NULL, 0))
 	{
 	  char buf[arg_size + arg_align - 1];
@@ -190,6 +610,15 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	}
       else
 	fn (data);
+      /* An undeferred detached task completes once its event has been
+	 fulfilled, which may have happened already.  */
+      if (__builtin_expect (task.detach, 0))
+	{
+	  gomp_sem_wait (&task.completion_sem);
+	  gomp_sem_destroy (&task.completion_sem);
+	}
+      gomp_tool_event (gomp_tool_event_task_complete, &task,
+		       (unsigned long) fn, 0);
       /* Access to "children" is normally done inside a task_lock
 	 mutex region, but the only way this particular task.children
 	 can be set is if this thread's task work function (fn)
@@ -228,6 +657,14 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task->kind = GOMP_TASK_IFFALSE;
       task->in_tied_task = parent->in_tied_task;
       task->taskgroup = taskgroup;
+      if (__builtin_expect (flags & GOMP_TASK_FLAG_DETACH, 0))
+	{
+	  task->detach = true;
+	  task->detach_team = team;
+	  *(void **) detach = task;
+	  if (data)
+	    *(void **) data = task;
+	}
       thr->task = task;
       if (cpyfn)
 	{
@@ -241,12 +678,21 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task->fn = fn;
       task->fn_data = arg;
       task->final_task = (flags & 2) >> 1;
+#ifdef GOMP_HAVE_TASK_CONTEXT
+      task->untied = (flags & GOMP_TASK_FLAG_UNTIED) != 0;
+#endif
+      task->priority = priority;
+      task->cost = cost;
+      task->place = place;
+      gomp_tool_event (gomp_tool_event_task_create, task, (unsigned long) fn,
+		       1);
       gomp_mutex_lock (&team->task_lock);
       /* If parallel or taskgroup has been cancelled, don't start new
-	 tasks.  */
+	 tasks.  A detached task is queued anyway, its event is known
+	 already and must stay valid until fulfilled.  */
       if (__builtin_expect ((gomp_team_barrier_cancelled (&team->barrier)
 			     || (taskgroup && taskgroup->cancelled))
-			    && !task->copy_ctors_done, 0))
+			    && !task->copy_ctors_done && !task->detach, 0))
 	{
 	  gomp_mutex_unlock (&team->task_lock);
 	  gomp_finish_task (task);
@@ -364,48 +810,10 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	      return;
 	    }
 	}
-      if (parent->children)
-	{
-	  task->next_child = parent->children;
-	  task->prev_child = parent->children->prev_child;
-	  task->next_child->prev_child = task;
-	  task->prev_child->next_child = task;
-	}
-      else
-	{
-	  task->next_child = task;
-	  task->prev_child = task;
-	}
-      parent->children = task;
+      gomp_task_insert_child (parent, task);
       if (taskgroup)
-	{
-	  if (taskgroup->children)
-	    {
-	      task->next_taskgroup = taskgroup->children;
-	      task->prev_taskgroup = taskgroup->children->prev_taskgroup;
-	      task->next_taskgroup->prev_taskgroup = task;
-	      task->prev_taskgroup->next_taskgroup = task;
-	    }
-	  else
-	    {
-	      task->next_taskgroup = task;
-	      task->prev_taskgroup = task;
-	    }
-	  taskgroup->children = task;
-	}
-      if (team->task_queue)
-	{
-	  task->next_queue = team->task_queue;
-	  task->prev_queue = team->task_queue->prev_queue;
-	  task->next_queue->prev_queue = task;
-	  task->prev_queue->next_queue = task;
-	}
-      else
-	{
-	  task->next_queue = task;
-	  task->prev_queue = task;
-	  team->task_queue = task;
-	}
+	gomp_task_insert_taskgroup (taskgroup, task);
+      gomp_task_queue_insert (gomp_task_queue_for (team, task), task);
       ++team->task_count;
       ++team->task_queued_count;
       gomp_team_barrier_set_task_pending (&team->barrier);
@@ -417,6 +825,361 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
     }
 }
 
+/* Create COUNT deferred sibling tasks running FN at once.  The tasks and
+   their ARG_SIZE bytes of argument each, aligned to ARG_ALIGN, are carved
+   out of a single allocation.  FILL is called for the tasks in order,
+   with thr->task set to the task, to store the argument of the I-th one
+   at its fn_data.  All tasks are linked in under a single task_lock
+   acquisition and at most one wake-up is issued for them.  */
+
+static void
+gomp_task_batch_create (void (*fn) (void *), unsigned long count,
+			size_t arg_size, size_t arg_align,
+			void (*fill) (struct gomp_task *task, unsigned long i,
+				      void *fill_data),
+			void *fill_data)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_task *parent = thr->task;
+  struct gomp_taskgroup *taskgroup = parent->taskgroup;
+  struct gomp_task_icv *icv = gomp_icv (false);
+  struct gomp_task_batch *batch;
+  size_t align = arg_align > 16 ? arg_align : 16;
+  size_t task_size = (sizeof (struct gomp_task) + align - 1) & ~(align - 1);
+  size_t slot_size = task_size + ((arg_size + align - 1) & ~(align - 1));
+  char *slots;
+  unsigned long i;
+  int do_wake;
+
+  if (arg_size > SIZE_MAX / 2
+      || count > (SIZE_MAX - sizeof (*batch) - align) / slot_size)
+    gomp_fatal ("Out of memory allocating %lu tasks", count);
+  batch = gomp_malloc (sizeof (*batch) + align - 1 + count * slot_size);
+  batch->refcount = count;
+  slots = (char *) (((uintptr_t) (batch + 1) + align - 1)
+		    & ~(uintptr_t) (align - 1));
+  for (i = 0; i < count; i++)
+    {
+      struct gomp_task *task = (struct gomp_task *) (slots + i * slot_size);
+
+      gomp_init_task (task, parent, icv);
+      task->kind = GOMP_TASK_IFFALSE;
+      task->in_tied_task = parent->in_tied_task;
+      task->taskgroup = taskgroup;
+      task->batch = batch;
+      task->fn = fn;
+      task->fn_data = (char *) task + task_size;
+      thr->task = task;
+      fill (task, i, fill_data);
+      thr->task = parent;
+      task->kind = GOMP_TASK_WAITING;
+      gomp_tool_event (gomp_tool_event_task_create, task, (unsigned long) fn,
+		       1);
+    }
+
+  gomp_mutex_lock (&team->task_lock);
+  /* If parallel or taskgroup has been cancelled, don't start new
+     tasks.  Tasks whose arguments have been built by copy constructors
+     still have to run to destruct them.  */
+  if (__builtin_expect ((gomp_team_barrier_cancelled (&team->barrier)
+			 || (taskgroup && taskgroup->cancelled))
+			&& !((struct gomp_task *) slots)->copy_ctors_done, 0))
+    {
+      gomp_mutex_unlock (&team->task_lock);
+      for (i = 0; i < count; i++)
+	gomp_finish_task ((struct gomp_task *) (slots + i * slot_size));
+      free (batch);
+      return;
+    }
+  if (taskgroup)
+    taskgroup->num_children += count;
+  for (i = 0; i < count; i++)
+    {
+      struct gomp_task *task = (struct gomp_task *) (slots + i * slot_size);
+
+      gomp_task_insert_child (parent, task);
+      if (taskgroup)
+	gomp_task_insert_taskgroup (taskgroup, task);
+      gomp_task_queue_insert (gomp_task_queue_for (team, task), task);
+    }
+  team->task_count += count;
+  team->task_queued_count += count;
+  gomp_team_barrier_set_task_pending (&team->barrier);
+  do_wake = (int) team->nthreads - (int) team->task_running_count
+	    - !parent->in_tied_task;
+  if (do_wake > 0 && (unsigned long) do_wake > count)
+    do_wake = count;
+  gomp_mutex_unlock (&team->task_lock);
+  if (do_wake > 0)
+    gomp_team_barrier_wake (&team->barrier, do_wake);
+}
+
+/* Return true if tasks created now by THR should be run undeferred one
+   by one through GOMP_task instead of being created as a batch.  */
+
+static inline bool
+gomp_task_batch_undeferred_p (struct gomp_thread *thr)
+{
+  struct gomp_team *team = thr->ts.team;
+
+  return (team == NULL
+	  || (thr->task && thr->task->final_task)
+	  || gomp_task_cutoff_p (thr));
+}
+
+/* Argument array passed to GOMP_task_batch.  */
+
+struct gomp_task_batch_args
+{
+  char *args;
+  size_t arg_size;
+};
+
+static void
+gomp_task_batch_fill (struct gomp_task *task, unsigned long i,
+		      void *fill_data)
+{
+  struct gomp_task_batch_args *d = fill_data;
+
+  memcpy (task->fn_data, d->args + i * d->arg_size, d->arg_size);
+}
+
+/* Create COUNT sibling tasks running FN, the I-th of them on a private
+   copy of the ARG_SIZE bytes at ARGS + I * ARG_SIZE, aligned to the
+   power of two ARG_ALIGN, like a task construct with a firstprivate
+   argument block.  This is equivalent to COUNT task constructs, but much
+   cheaper for wide fan-outs.  */
+
+void
+GOMP_task_batch (void (*fn) (void *), void *args, unsigned long arg_size,
+		 unsigned long arg_align, unsigned long count)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_task_batch_args d = { args, arg_size };
+  unsigned long i;
+
+  if (count == 0)
+    return;
+  thr->task_cost = 0;
+  thr->task_place = 0;
+  if (gomp_task_batch_undeferred_p (thr))
+    {
+      for (i = 0; i < count; i++)
+	GOMP_task (fn, (char *) args + i * arg_size, NULL, arg_size,
+		   arg_align, true, 0, NULL, 0, NULL);
+      return;
+    }
+
+  /* If parallel or taskgroup has been cancelled, don't start new tasks.  */
+  if (gomp_team_barrier_cancelled (&thr->ts.team->barrier)
+      || (thr->task->taskgroup && thr->task->taskgroup->cancelled))
+    return;
+
+  gomp_task_batch_create (fn, count, arg_size, arg_align,
+			  gomp_task_batch_fill, &d);
+}
+
+/* Argument block of the tasks created by GOMP_task_range.  */
+
+struct gomp_task_range_arg
+{
+  void (*fn) (void *, long);
+  void *data;
+  long i;
+};
+
+static void
+gomp_task_range_fn (void *arg)
+{
+  struct gomp_task_range_arg *r = arg;
+
+  r->fn (r->data, r->i);
+}
+
+static void
+gomp_task_range_fill (struct gomp_task *task, unsigned long i,
+		      void *fill_data)
+{
+  struct gomp_task_range_arg *r = task->fn_data;
+
+  *r = *(struct gomp_task_range_arg *) fill_data;
+  r->i += i;
+}
+
+/* Create one task calling FN (DATA, I) for each I in [START, END).
+   DATA is shared by all the tasks.  */
+
+void
+GOMP_task_range (void (*fn) (void *, long), void *data, long start, long end)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_task_range_arg r = { fn, data, start };
+
+  if (start >= end)
+    return;
+  thr->task_cost = 0;
+  thr->task_place = 0;
+  if (gomp_task_batch_undeferred_p (thr))
+    {
+      for (; r.i < end; r.i++)
+	GOMP_task (gomp_task_range_fn, &r, NULL, sizeof (r),
+		   __alignof__ (r), true, 0, NULL, 0, NULL);
+      return;
+    }
+
+  /* If parallel or taskgroup has been cancelled, don't start new tasks.  */
+  if (gomp_team_barrier_cancelled (&thr->ts.team->barrier)
+      || (thr->task->taskgroup && thr->task->taskgroup->cancelled))
+    return;
+
+  gomp_task_batch_create (gomp_task_range_fn,
+			  (unsigned long) end - (unsigned long) start,
+			  sizeof (r), __alignof__ (r), gomp_task_range_fill,
+			  &r);
+}
+
+#define TYPE long
+#define UTYPE unsigned long
+#define TYPE_is_long 1
+#include "taskloop.c"
+#undef TYPE
+#undef UTYPE
+#undef TYPE_is_long
+
+#define TYPE unsigned long long
+#define UTYPE TYPE
+#define GOMP_taskloop GOMP_taskloop_ull
+#define gomp_taskloop_fill gomp_taskloop_ull_fill
+#define gomp_taskloop_fill_data gomp_taskloop_ull_fill_data
+#include "taskloop.c"
+#undef TYPE
+#undef UTYPE
+#undef GOMP_taskloop
+#undef gomp_taskloop_fill
+#undef gomp_taskloop_fill_data
+
+/* Argument block of the tasks created by GOMP_taskloop_range.  */
+
+struct gomp_taskloop_chunk_arg
+{
+  void (*fn) (void *, long, long);
+  void *data;
+  long start, end;
+};
+
+/* Iterator over the chunks of a GOMP_taskloop_range.  Chunks are either
+   NCHUNKS chunks of DIV or DIV + 1 iterations, or given by CHUNKSIZES;
+   empty chunks are skipped.  */
+
+struct gomp_taskloop_chunks
+{
+  struct gomp_taskloop_chunk_arg next;
+  unsigned long nchunks, div, mod, i;
+  unsigned *chunksizes;
+};
+
+static void
+gomp_taskloop_next_chunk (struct gomp_taskloop_chunks *c)
+{
+  unsigned long size;
+
+  c->next.start = c->next.end;
+  if (c->chunksizes)
+    do
+      size = c->chunksizes[c->i++];
+    while (size == 0);
+  else
+    size = c->div + (c->i++ < c->mod);
+  c->next.end = c->next.start + size;
+}
+
+static void
+gomp_taskloop_chunk_fn (void *arg)
+{
+  struct gomp_taskloop_chunk_arg *c = arg;
+
+  c->fn (c->data, c->start, c->end);
+}
+
+static void
+gomp_taskloop_chunk_fill (struct gomp_task *task,
+			  unsigned long i __attribute__((unused)),
+			  void *fill_data)
+{
+  struct gomp_taskloop_chunks *c = fill_data;
+
+  gomp_taskloop_next_chunk (c);
+  *(struct gomp_taskloop_chunk_arg *) task->fn_data = c->next;
+}
+
+/* Run FN (DATA, LO, HI) over subranges [LO, HI) partitioning
+   [START, END) as tasks, and wait for them as a taskloop construct
+   would.  With GRAINSIZE > 0 each task gets at least GRAINSIZE
+   iterations, otherwise NUM_TASKS tasks are created, or one per thread
+   of the team if NUM_TASKS is not positive.  If WEIGHTED and the
+   workload last given to omp_set_workload has one entry per iteration,
+   the chunks have about the same total workload rather than the same
+   number of iterations.  */
+
+void
+GOMP_taskloop_range (void (*fn) (void *, long, long), void *data,
+		     long start, long end, long grainsize, long num_tasks,
+		     bool weighted)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_taskloop_chunks c;
+  unsigned long n, i;
+
+  if (start >= end)
+    return;
+  n = (unsigned long) end - (unsigned long) start;
+
+  if (grainsize > 0)
+    c.nchunks = n / grainsize ? n / grainsize : 1;
+  else if (num_tasks > 0)
+    c.nchunks = num_tasks;
+  else
+    c.nchunks = team ? team->nthreads : 1;
+  if (c.nchunks > n)
+    c.nchunks = n;
+
+  c.next.fn = fn;
+  c.next.data = data;
+  c.next.end = start;
+  c.div = n / c.nchunks;
+  c.mod = n % c.nchunks;
+  c.i = 0;
+  c.chunksizes = NULL;
+  if (weighted && n <= UINT_MAX && c.nchunks > 1)
+    c.chunksizes = gomp_loop_workload_chunksizes (n, c.nchunks);
+  if (c.chunksizes)
+    {
+      unsigned long nonempty = 0;
+      for (i = 0; i < c.nchunks; i++)
+	nonempty += c.chunksizes[i] != 0;
+      c.nchunks = nonempty;
+    }
+
+  thr->task_cost = 0;
+  thr->task_place = 0;
+  GOMP_taskgroup_start ();
+  if (gomp_task_batch_undeferred_p (thr))
+    for (i = 0; i < c.nchunks; i++)
+      {
+	gomp_taskloop_next_chunk (&c);
+	GOMP_task (gomp_taskloop_chunk_fn, &c.next, NULL, sizeof (c.next),
+		   __alignof__ (c.next), true, 0, NULL, 0, NULL);
+      }
+  else
+    gomp_task_batch_create (gomp_taskloop_chunk_fn, c.nchunks,
+			    sizeof (c.next), __alignof__ (c.next),
+			    gomp_taskloop_chunk_fill, &c);
+  GOMP_taskgroup_end ();
+  free (c.chunksizes);
+}
+
 static inline bool
 gomp_task_run_pre (struct gomp_task *child_task, struct gomp_task *parent,
 		   struct gomp_taskgroup *taskgroup, struct gomp_team *team)
@@ -425,25 +1188,94 @@ gomp_task_run_pre (struct gomp_task *child_task, struct gomp_task *parent,
     parent->children = child_task->next_child;
   if (taskgroup && taskgroup->children == child_task)
     taskgroup->children = child_task->next_taskgroup;
-  child_task->prev_queue->next_queue = child_task->next_queue;
-  child_task->next_queue->prev_queue = child_task->prev_queue;
-  if (team->task_queue == child_task)
-    {
-      if (child_task->next_queue != child_task)
-	team->task_queue = child_task->next_queue;
-      else
-	team->task_queue = NULL;
-    }
+  gomp_task_queue_remove (gomp_task_queue_for (team, child_task),
+			  child_task);
   child_task->kind = GOMP_TASK_TIED;
   if (--team->task_queued_count == 0)
     gomp_team_barrier_clear_task_pending (&team->barrier);
+  /* A task resumed after being suspended has started already.  */
   if ((gomp_team_barrier_cancelled (&team->barrier)
        || (taskgroup && taskgroup->cancelled))
-      && !child_task->copy_ctors_done)
+      && !child_task->copy_ctors_done
+      && child_task->context == NULL)
     return true;
   return false;
 }
 
+#ifdef GOMP_HAVE_TASK_CONTEXT
+static void gomp_task_requeue (struct gomp_team *, struct gomp_task *);
+#endif
+
+/* Let PARENT, which waits in GOMP_taskwait, continue: wake its thread
+   or, if PARENT is an untied task that got suspended, queue it again.  */
+
+static inline void
+gomp_task_taskwait_wake (struct gomp_team *team, struct gomp_task *parent)
+{
+  parent->in_taskwait = false;
+#ifdef GOMP_HAVE_TASK_CONTEXT
+  if (parent->suspended)
+    {
+      gomp_task_requeue (team, parent);
+      return;
+    }
+#endif
+  gomp_sem_post (&parent->taskwait_sem);
+}
+
+#ifdef GOMP_HAVE_TASK_CONTEXT
+/* Queue the suspended untied TASK again.  It is moved among the waiting
+   tasks at the front of the children lists of its parent and taskgroup,
+   so that those waiting for it can resume it themselves.  */
+
+static void
+gomp_task_requeue (struct gomp_team *team, struct gomp_task *task)
+{
+  struct gomp_task *parent = task->parent;
+  struct gomp_taskgroup *taskgroup = task->taskgroup;
+
+  task->suspended = false;
+  task->kind = GOMP_TASK_WAITING;
+  if (parent)
+    {
+      if (task->next_child == task)
+	parent->children = NULL;
+      else
+	{
+	  task->prev_child->next_child = task->next_child;
+	  task->next_child->prev_child = task->prev_child;
+	  if (parent->children == task)
+	    parent->children = task->next_child;
+	}
+      gomp_task_insert_child (parent, task);
+      if (parent->in_taskwait)
+	gomp_task_taskwait_wake (team, parent);
+    }
+  if (taskgroup)
+    {
+      if (task->next_taskgroup == task)
+	taskgroup->children = NULL;
+      else
+	{
+	  task->prev_taskgroup->next_taskgroup = task->next_taskgroup;
+	  task->next_taskgroup->prev_taskgroup = task->prev_taskgroup;
+	  if (taskgroup->children == task)
+	    taskgroup->children = task->next_taskgroup;
+	}
+      gomp_task_insert_taskgroup (taskgroup, task);
+      if (taskgroup->in_taskgroup_wait)
+	{
+	  taskgroup->in_taskgroup_wait = false;
+	  gomp_sem_post (&taskgroup->taskgroup_sem);
+	}
+    }
+  gomp_task_queue_insert (gomp_task_queue_for (team, task), task);
+  ++team->task_queued_count;
+  gomp_team_barrier_set_task_pending (&team->barrier);
+  gomp_team_barrier_wake (&team->barrier, 1);
+}
+#endif
+
 static void
 gomp_task_run_post_handle_depend_hash (struct gomp_task *child_task)
 {
@@ -472,9 +1304,17 @@ gomp_task_run_post_handle_depend_hash (struct gomp_task *child_task)
       }
 }
 
+/* Release the tasks that depend on CHILD_TASK and queue those that have
+   no dependencies left.  If SUCCESSOR is non-NULL, the first released
+   task is also stored there, so that the caller can run it next on the
+   same thread while the data CHILD_TASK produced is still in its caches.
+   It is queued like the others, so the caller has to take it off the
+   queue with gomp_task_run_pre before dropping task_lock.  */
+
 static size_t
 gomp_task_run_post_handle_dependers (struct gomp_task *child_task,
-				     struct gomp_team *team)
+				     struct gomp_team *team,
+				     struct gomp_task **successor)
 {
   struct gomp_task *parent = child_task->parent;
   size_t i, count = child_task->dependers->n_elem, ret = 0;
@@ -484,62 +1324,26 @@ gomp_task_run_post_handle_dependers (struct gomp_task *child_task,
       if (--task->num_dependees != 0)
 	continue;
 
+      if (successor && *successor == NULL)
+	*successor = task;
+
       struct gomp_taskgroup *taskgroup = task->taskgroup;
       if (parent)
 	{
-	  if (parent->children)
-	    {
-	      task->next_child = parent->children;
-	      task->prev_child = parent->children->prev_child;
-	      task->next_child->prev_child = task;
-	      task->prev_child->next_child = task;
-	    }
-	  else
-	    {
-	      task->next_child = task;
-	      task->prev_child = task;
-	    }
-	  parent->children = task;
+	  gomp_task_insert_child (parent, task);
 	  if (parent->in_taskwait)
-	    {
-	      parent->in_taskwait = false;
-	      gomp_sem_post (&parent->taskwait_sem);
-	    }
+	    gomp_task_taskwait_wake (team, parent);
 	}
       if (taskgroup)
 	{
-	  if (taskgroup->children)
-	    {
-	      task->next_taskgroup = taskgroup->children;
-	      task->prev_taskgroup = taskgroup->children->prev_taskgroup;
-	      task->next_taskgroup->prev_taskgroup = task;
-	      task->prev_taskgroup->next_taskgroup = task;
-	    }
-	  else
-	    {
-	      task->next_taskgroup = task;
-	      task->prev_taskgroup = task;
-	    }
-	  taskgroup->children = task;
+	  gomp_task_insert_taskgroup (taskgroup, task);
 	  if (taskgroup->in_taskgroup_wait)
 	    {
 	      taskgroup->in_taskgroup_wait = false;
 	      gomp_sem_post (&taskgroup->taskgroup_sem);
 	    }
 	}
-      if (team->task_queue)
-	{
-	  task->next_queue = team->task_queue;
-	  task->prev_queue = team->task_queue->prev_queue;
-	  task->next_queue->prev_queue = task;
-	  task->prev_queue->next_queue = task;
-	}
-      else
-	{
-	  task->next_queue = task;
-	  task->prev_queue = task;
-	  team->task_queue = task;
-	}
+      gomp_task_queue_insert (gomp_task_queue_for (team, task), task);
       ++team->task_count;
       ++team->task_queued_count;
       ++ret;
@@ -553,7 +1357,8 @@ gomp_task_run_post_handle_dependers (struct gomp_task *child_task,
 
 static inline size_t
 gomp_task_run_post_handle_depend (struct gomp_task *child_task,
-				  struct gomp_team *team)
+				  struct gomp_team *team,
+				  struct gomp_task **successor)
 {
   if (child_task->depend_count == 0)
     return 0;
@@ -566,11 +1371,12 @@ gomp_task_run_post_handle_depend (struct gomp_task *child_task,
   if (child_task->dependers == NULL)
     return 0;
 
-  return gomp_task_run_post_handle_dependers (child_task, team);
+  return gomp_task_run_post_handle_dependers (child_task, team, successor);
 }
 
 static inline void
-gomp_task_run_post_remove_parent (struct gomp_task *child_task)
+gomp_task_run_post_remove_parent (struct gomp_task *child_task,
+				  struct gomp_team *team)
 {
   struct gomp_task *parent = child_task->parent;
   if (parent == NULL)
@@ -590,10 +1396,7 @@ gomp_task_run_post_remove_parent (struct gomp_task *child_task)
 	 before the NULL is written.  */
       __atomic_store_n (&parent->children, NULL, MEMMODEL_RELEASE);
       if (parent->in_taskwait)
-	{
-	  parent->in_taskwait = false;
-	  gomp_sem_post (&parent->taskwait_sem);
-	}
+	gomp_task_taskwait_wake (team, parent);
     }
 }
 
@@ -639,6 +1442,8 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
   struct gomp_task *task = thr->task;
   struct gomp_task *child_task = NULL;
   struct gomp_task *to_free = NULL;
+  struct gomp_task *next_task = NULL;
+  unsigned long successor_depth = 0;
   int do_wake = 0;
 
   gomp_mutex_lock (&team->task_lock);
@@ -657,17 +1462,29 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
   while (1)
     {
       bool cancelled = false;
-      if (team->task_queue != NULL)
+      child_task = gomp_task_queue_next (team, thr);
+      if (next_task != NULL
+	  && (child_task == NULL
+	      || child_task->priority <= next_task->priority))
+	{
+	  /* Run a task released by the one we just finished right away,
+	     instead of the oldest queued one, unless something more
+	     urgent is waiting.  */
+	  child_task = next_task;
+	  successor_depth++;
+	}
+      else
+	successor_depth = 0;
+      next_task = NULL;
+      if (child_task)
 	{
-	  child_task = team->task_queue;
 	  cancelled = gomp_task_run_pre (child_task, child_task->parent,
 					 child_task->taskgroup, team);
 	  if (__builtin_expect (cancelled, 0))
 	    {
 	      if (to_free)
 		{
-		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -683,14 +1500,20 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	}
       if (to_free)
 	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
 	{
 	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
+	  if (__builtin_expect (!gomp_task_run_fn (team, child_task), 0))
+	    {
+	      /* CHILD_TASK got suspended and will be queued again.  */
+	      thr->task = task;
+	      child_task = NULL;
+	      team->task_running_count--;
+	      continue;
+	    }
 	  thr->task = task;
 	}
       else
@@ -699,9 +1522,21 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
       if (child_task)
 	{
 	 finish_cancelled:;
+	  if (__builtin_expect (child_task->detach, 0))
+	    {
+	      /* CHILD_TASK completes in omp_fulfill_event.  */
+	      child_task->kind = GOMP_TASK_DETACHED;
+	      child_task = NULL;
+	      if (!cancelled)
+		team->task_running_count--;
+	      continue;
+	    }
 	  size_t new_tasks
-	    = gomp_task_run_post_handle_depend (child_task, team);
-	  gomp_task_run_post_remove_parent (child_task);
+	    = gomp_task_run_post_handle_depend (child_task, team,
+						successor_depth
+						< gomp_task_successor_depth_var
+						? &next_task : NULL);
+	  gomp_task_run_post_remove_parent (child_task, team);
 	  gomp_clear_parent (child_task->children);
 	  gomp_task_run_post_remove_taskgroup (child_task);
 	  to_free = child_task;
@@ -711,8 +1546,8 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	  if (new_tasks > 1)
 	    {
 	      do_wake = team->nthreads - team->task_running_count;
-	      if (do_wake > new_tasks)
-		do_wake = new_tasks;
+	      if (do_wake > new_tasks - (next_task != NULL))
+		do_wake = new_tasks - (next_task != NULL);
 	    }
 	  if (--team->task_count == 0
 	      && gomp_team_barrier_waiting_for_tasks (&team->barrier))
@@ -736,6 +1571,8 @@ GOMP_taskwait (void)
   struct gomp_task *task = thr->task;
   struct gomp_task *child_task = NULL;
   struct gomp_task *to_free = NULL;
+  struct gomp_task *next_task = NULL;
+  unsigned long successor_depth = 0;
   int do_wake = 0;
 
   /* The acquire barrier on load of task->children here synchronizes
@@ -757,14 +1594,27 @@ GOMP_taskwait (void)
 	  gomp_mutex_unlock (&team->task_lock);
 	  if (to_free)
 	    {
-	      gomp_finish_task (to_free);
-	      free (to_free);
+	      gomp_free_task (to_free);
 	    }
 	  return;
 	}
-      if (task->children->kind == GOMP_TASK_WAITING)
+      if (next_task != NULL
+	  && task->children->kind == GOMP_TASK_WAITING
+	  && task->children->priority > next_task->priority)
+	next_task = NULL;
+      if (next_task != NULL || task->children->kind == GOMP_TASK_WAITING)
 	{
-	  child_task = task->children;
+	  if (next_task != NULL)
+	    {
+	      child_task = next_task;
+	      next_task = NULL;
+	      successor_depth++;
+	    }
+	  else
+	    {
+	      child_task = task->children;
+	      successor_depth = 0;
+	    }
 	  cancelled
 	    = gomp_task_run_pre (child_task, task, child_task->taskgroup,
 				 team);
@@ -772,17 +1622,38 @@ GOMP_taskwait (void)
 	    {
 	      if (to_free)
 		{
-		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
 	    }
 	}
       else
-	/* All tasks we are waiting for are already running
-	   in other threads.  Wait for them.  */
-	task->in_taskwait = true;
+	{
+	  /* All tasks we are waiting for are already running
+	     in other threads.  Wait for them.  */
+	  task->in_taskwait = true;
+#ifdef GOMP_HAVE_TASK_CONTEXT
+	  if (task->context != NULL)
+	    {
+	      /* Rather than blocking the thread, an untied task hands it
+		 back to the scheduling loop it was run from.  */
+	      if (do_wake)
+		{
+		  gomp_team_barrier_wake (&team->barrier, do_wake);
+		  do_wake = 0;
+		}
+	      if (to_free)
+		{
+		  gomp_free_task (to_free);
+		  to_free = NULL;
+		}
+	      thr = gomp_task_suspend (task);
+	      gomp_mutex_lock (&team->task_lock);
+	      continue;
+	    }
+#endif
+	}
       gomp_mutex_unlock (&team->task_lock);
       if (do_wake)
 	{
@@ -791,14 +1662,18 @@ GOMP_taskwait (void)
 	}
       if (to_free)
 	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
 	{
 	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
+	  if (__builtin_expect (!gomp_task_run_fn (team, child_task), 0))
+	    {
+	      thr->task = task;
+	      child_task = NULL;
+	      continue;
+	    }
 	  thr->task = task;
 	}
       else
@@ -807,8 +1682,18 @@ GOMP_taskwait (void)
       if (child_task)
 	{
 	 finish_cancelled:;
+	  if (__builtin_expect (child_task->detach, 0))
+	    {
+	      /* CHILD_TASK completes in omp_fulfill_event.  */
+	      child_task->kind = GOMP_TASK_DETACHED;
+	      child_task = NULL;
+	      continue;
+	    }
 	  size_t new_tasks
-	    = gomp_task_run_post_handle_depend (child_task, team);
+	    = gomp_task_run_post_handle_depend (child_task, team,
+						successor_depth
+						< gomp_task_successor_depth_var
+						? &next_task : NULL);
 	  child_task->prev_child->next_child = child_task->next_child;
 	  child_task->next_child->prev_child = child_task->prev_child;
 	  if (task->children == child_task)
@@ -827,8 +1712,8 @@ GOMP_taskwait (void)
 	    {
 	      do_wake = team->nthreads - team->task_running_count
 			- !task->in_tied_task;
-	      if (do_wake > new_tasks)
-		do_wake = new_tasks;
+	      if (do_wake > new_tasks - (next_task != NULL))
+		do_wake = new_tasks - (next_task != NULL);
 	    }
 	}
     }
@@ -875,6 +1760,8 @@ GOMP_taskgroup_end (void)
   struct gomp_taskgroup *taskgroup;
   struct gomp_task *child_task = NULL;
   struct gomp_task *to_free = NULL;
+  struct gomp_task *next_task = NULL;
+  unsigned long successor_depth = 0;
   int do_wake = 0;
 
   if (team == NULL)
@@ -901,14 +1788,28 @@ GOMP_taskgroup_end (void)
 	  gomp_mutex_unlock (&team->task_lock);
 	  if (to_free)
 	    {
-	      gomp_finish_task (to_free);
-	      free (to_free);
+	      gomp_free_task (to_free);
 	    }
 	  goto finish;
 	}
-      if (taskgroup->children->kind == GOMP_TASK_WAITING)
+      if (next_task != NULL
+	  && taskgroup->children->kind == GOMP_TASK_WAITING
+	  && taskgroup->children->priority > next_task->priority)
+	next_task = NULL;
+      if (next_task != NULL
+	  || taskgroup->children->kind == GOMP_TASK_WAITING)
 	{
-	  child_task = taskgroup->children;
+	  if (next_task != NULL)
+	    {
+	      child_task = next_task;
+	      next_task = NULL;
+	      successor_depth++;
+	    }
+	  else
+	    {
+	      child_task = taskgroup->children;
+	      successor_depth = 0;
+	    }
 	  cancelled
 	    = gomp_task_run_pre (child_task, child_task->parent, taskgroup,
 				 team);
@@ -916,8 +1817,7 @@ GOMP_taskgroup_end (void)
 	    {
 	      if (to_free)
 		{
-		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -938,14 +1838,18 @@ GOMP_taskgroup_end (void)
 	}
       if (to_free)
 	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
 	{
 	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
+	  if (__builtin_expect (!gomp_task_run_fn (team, child_task), 0))
+	    {
+	      thr->task = task;
+	      child_task = NULL;
+	      continue;
+	    }
 	  thr->task = task;
 	}
       else
@@ -954,8 +1858,22 @@ GOMP_taskgroup_end (void)
       if (child_task)
 	{
 	 finish_cancelled:;
+	  if (__builtin_expect (child_task->detach, 0))
+	    {
+	      /* CHILD_TASK completes in omp_fulfill_event.  */
+	      child_task->kind = GOMP_TASK_DETACHED;
+	      child_task = NULL;
+	      continue;
+	    }
 	  size_t new_tasks
-	    = gomp_task_run_post_handle_depend (child_task, team);
+	    = gomp_task_run_post_handle_depend (child_task, team,
+						successor_depth
+						< gomp_task_successor_depth_var
+						? &next_task : NULL);
+	  /* The successor may belong to a nested taskgroup, which we
+	     must not run from here.  */
+	  if (next_task != NULL && next_task->taskgroup != taskgroup)
+	    next_task = NULL;
 	  child_task->prev_taskgroup->next_taskgroup
 	    = child_task->next_taskgroup;
 	  child_task->next_taskgroup->prev_taskgroup
@@ -968,7 +1886,7 @@ GOMP_taskgroup_end (void)
 	      else
 		taskgroup->children = NULL;
 	    }
-	  gomp_task_run_post_remove_parent (child_task);
+	  gomp_task_run_post_remove_parent (child_task, team);
 	  gomp_clear_parent (child_task->children);
 	  to_free = child_task;
 	  child_task = NULL;
@@ -977,8 +1895,8 @@ GOMP_taskgroup_end (void)
 	    {
 	      do_wake = team->nthreads - team->task_running_count
 			- !task->in_tied_task;
-	      if (do_wake > new_tasks)
-		do_wake = new_tasks;
+	      if (do_wake > new_tasks - (next_task != NULL))
+		do_wake = new_tasks - (next_task != NULL);
 	    }
 	}
     }
@@ -989,6 +1907,125 @@ GOMP_taskgroup_end (void)
   free (taskgroup);
 }
 
+/* Detach the calling explicit task and return its event.  The task
+   then completes, releasing the tasks that depend on it and those
+   waiting for it, only once it has returned and the event has been
+   fulfilled with omp_fulfill_event, which may be done by any thread.  */
+
+omp_event_handle_t
+GOMP_task_detach (void)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_task *task = thr->task;
+
+  if (task == NULL || task->kind == GOMP_TASK_IMPLICIT)
+    gomp_fatal ("GOMP_task_detach called outside of an explicit task");
+  if (!task->detach)
+    {
+      task->detach = true;
+      if (task->kind == GOMP_TASK_IFFALSE)
+	gomp_sem_init (&task->completion_sem, 0);
+      else
+	task->detach_team = thr->ts.team;
+    }
+  return (omp_event_handle_t) (uintptr_t) task;
+}
+
+void
+omp_fulfill_event (omp_event_handle_t event)
+{
+  struct gomp_task *task = (struct gomp_task *) (uintptr_t) event;
+  struct gomp_team *team = task->detach_team;
+  size_t new_tasks;
+  int do_wake = 0;
+
+  if (team == NULL)
+    {
+      /* The task is undeferred, its thread waits for this in GOMP_task.  */
+      gomp_sem_post (&task->completion_sem);
+      return;
+    }
+
+  gomp_mutex_lock (&team->task_lock);
+  task->detach = false;
+  if (task->kind != GOMP_TASK_DETACHED)
+    {
+      /* The task is still running and completes when it returns.  */
+      gomp_mutex_unlock (&team->task_lock);
+      return;
+    }
+
+  new_tasks = gomp_task_run_post_handle_depend (task, team, NULL);
+  gomp_task_run_post_remove_parent (task, team);
+  gomp_clear_parent (task->children);
+  gomp_task_run_post_remove_taskgroup (task);
+  if (new_tasks)
+    {
+      gomp_team_barrier_set_task_pending (&team->barrier);
+      do_wake = team->nthreads - team->task_running_count;
+      if (do_wake > new_tasks)
+	do_wake = new_tasks;
+    }
+  if (--team->task_count == 0
+      && gomp_team_barrier_waiting_for_tasks (&team->barrier))
+    {
+      /* The team is waiting in a barrier for this task only.  */
+      gomp_team_barrier_done (&team->barrier, team->barrier.generation);
+      do_wake = 0;
+      gomp_mutex_unlock (&team->task_lock);
+      gomp_team_barrier_wake (&team->barrier, 0);
+    }
+  else
+    gomp_mutex_unlock (&team->task_lock);
+  if (do_wake)
+    gomp_team_barrier_wake (&team->barrier, do_wake);
+  gomp_free_task (task);
+}
+
+/* Give an estimate of the cost of the next task created by the calling
+   thread, in arbitrary units.  Among ready tasks of equal priority, the
+   ones with the largest estimate are started first (LPT order); tasks
+   without an estimate come last, in creation order.  */
+
+void
+GOMP_set_task_cost (unsigned long cost)
+{
+  gomp_thread ()->task_cost = cost;
+}
+
+/* Ask for the next task created by the calling thread to run preferably
+   on the threads bound to the place nearest to the memory at ADDR.  This
+   only has an effect if threads are bound to places spanning several
+   NUMA nodes and ADDR has been touched already.  */
+
+void
+GOMP_set_task_affinity (const void *addr)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  int place = -1;
+
+  if (thr->place)
+    place = gomp_affinity_place_of_address (addr);
+  thr->task_place = place + 1;
+}
+
+/* Ask for the next task created by the calling thread to run preferably
+   on the threads bound to place PLACE_NUM, counted from 0 in the
+   place-list.  Threads of other places only run it once the shared and
+   their own queues are empty.  */
+
+void
+GOMP_set_task_place (int place_num)
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  if (thr->place && place_num >= 0
+      && (unsigned long) place_num < gomp_places_list_len)
+    thr->task_place = place_num + 1;
+  else
+    thr->task_place = 0;
+}
+
 int
 omp_in_final (void)
 {
@@ -0,0 +1,193 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file handles the taskloop construct.  It is included twice, once
+   for the long and once for unsigned long long variant.  */
+
+/* State shared by the tasks of one taskloop while they are created.  */
+
+struct gomp_taskloop_fill_data
+{
+  void *data;
+  void (*cpyfn) (void *, void *);
+  long arg_size;
+  TYPE start, task_step, step;
+  unsigned long nfirst;
+  int priority;
+  bool final_task;
+};
+
+/* Build the argument block of the I-th task of a taskloop: a copy of
+   the compiler's data block whose first two TYPE fields are the bounds
+   of the iterations the task runs.  */
+
+static void
+gomp_taskloop_fill (struct gomp_task *task, unsigned long i, void *fill_data)
+{
+  struct gomp_taskloop_fill_data *d = fill_data;
+  char *arg = task->fn_data;
+
+  if (d->cpyfn)
+    {
+      d->cpyfn (arg, d->data);
+      task->copy_ctors_done = true;
+    }
+  else
+    memcpy (arg, d->data, d->arg_size);
+  ((TYPE *) arg)[0] = d->start;
+  d->start += d->task_step;
+  ((TYPE *) arg)[1] = d->start;
+  if (i == d->nfirst)
+    d->task_step -= d->step;
+  task->priority = d->priority;
+  task->final_task = d->final_task;
+}
+
+/* Called when encountering a taskloop directive.  The iterations from
+   START to END by STEP are split into NUM_TASKS tasks or, if
+   GOMP_TASK_FLAG_GRAINSIZE is set in FLAGS, into tasks of at least
+   NUM_TASKS iterations each.  Unless GOMP_TASK_FLAG_NOGROUP is set, the
+   tasks are awaited as if in a taskgroup.  */
+
+void
+GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
+	       long arg_size, long arg_align, unsigned flags,
+	       unsigned long num_tasks, int priority,
+	       TYPE start, TYPE end, TYPE step)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_taskloop_fill_data d;
+  unsigned long i;
+
+#ifdef HAVE_BROKEN_POSIX_SEMAPHORES
+  /* If pthread_mutex_* is used for omp_*lock*, then each task must be
+     tied to one thread all the time.  This means UNTIED tasks must be
+     tied and if CPYFN is non-NULL IF(0) must be forced, as CPYFN
+     might be running on different thread than FN.  */
+  if (cpyfn)
+    flags &= ~GOMP_TASK_FLAG_IF;
+  flags &= ~GOMP_TASK_FLAG_UNTIED;
+#endif
+
+  /* If parallel or taskgroup has been cancelled, don't start new tasks.  */
+  if (team && gomp_team_barrier_cancelled (&team->barrier))
+    return;
+
+#ifdef TYPE_is_long
+  TYPE s = step;
+  if (step > 0)
+    {
+      if (start >= end)
+	return;
+      s--;
+    }
+  else
+    {
+      if (start <= end)
+	return;
+      s++;
+    }
+  UTYPE n = (end - start + s) / step;
+#else
+  UTYPE n;
+  if (flags & GOMP_TASK_FLAG_UP)
+    {
+      if (start >= end)
+	return;
+      n = (end - start + step - 1) / step;
+    }
+  else
+    {
+      if (start <= end)
+	return;
+      n = (start - end - step - 1) / -step;
+    }
+#endif
+
+  if (flags & GOMP_TASK_FLAG_GRAINSIZE)
+    {
+      UTYPE grainsize = num_tasks ? num_tasks : 1;
+      num_tasks = n / grainsize ? n / grainsize : 1;
+    }
+  else
+    {
+      if (num_tasks == 0)
+	num_tasks = team ? team->nthreads : 1;
+      if (num_tasks > n)
+	num_tasks = n;
+    }
+
+  /* The first N % NUM_TASKS tasks get one iteration more than the
+     others.  */
+  d.data = data;
+  d.cpyfn = cpyfn;
+  d.arg_size = arg_size;
+  d.start = start;
+  d.step = step;
+  d.task_step = (TYPE) (n / num_tasks) * step;
+  d.nfirst = n;
+  if (n % num_tasks)
+    {
+      d.task_step += step;
+      d.nfirst = n % num_tasks - 1;
+    }
+  if ((flags & GOMP_TASK_FLAG_PRIORITY) == 0 || priority < 0)
+    priority = 0;
+  else if (priority > gomp_max_task_priority_var)
+    priority = gomp_max_task_priority_var;
+  d.priority = priority;
+  d.final_task = (flags & GOMP_TASK_FLAG_FINAL) != 0;
+
+  if ((flags & GOMP_TASK_FLAG_NOGROUP) == 0)
+    GOMP_taskgroup_start ();
+
+  if ((flags & GOMP_TASK_FLAG_IF) == 0
+      || gomp_task_batch_undeferred_p (thr))
+    {
+      for (i = 0; i < num_tasks; i++)
+	{
+	  char buf[arg_size + arg_align - 1];
+	  char *arg = (char *) (((uintptr_t) buf + arg_align - 1)
+				& ~(uintptr_t) (arg_align - 1));
+
+	  if (cpyfn)
+	    cpyfn (arg, data);
+	  else
+	    memcpy (arg, data, arg_size);
+	  ((TYPE *) arg)[0] = d.start;
+	  d.start += d.task_step;
+	  ((TYPE *) arg)[1] = d.start;
+	  if (i == d.nfirst)
+	    d.task_step -= step;
+	  GOMP_task (fn, arg, NULL, arg_size, arg_align, false,
+		     flags & GOMP_TASK_FLAG_FINAL, NULL, 0, NULL);
+	}
+    }
+  else
+    gomp_task_batch_create (fn, num_tasks, arg_size, arg_align,
+			    gomp_taskloop_fill, &d);
+
+  if ((flags & GOMP_TASK_FLAG_NOGROUP) == 0)
+    GOMP_taskgroup_end ();
+}
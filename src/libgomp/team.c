@@ -26,6 +26,7 @@
    creation and termination.  */
 
 #include "libgomp.h"
+#include "context.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -58,6 +59,23 @@ struct gomp_thread_start_data
 };
 
 
+/* Make the runtime data of THR, a pooled thread bound to a place, local
+   to its NUMA node.  The gomp_thread itself was first touched by the
+   thread that created THR, along with the rest of its TLS block, and
+   implicit tasks are normally part of the team, which the master
+   allocates.  THR gets two implicit tasks of its own instead, one of which
+   can be set up by the master for the next team while THR still finishes
+   the other one.  */
+
+static void
+gomp_thread_numa_local (struct gomp_thread *thr)
+{
+  gomp_affinity_move_local (thr, sizeof (*thr));
+  thr->implicit_tasks = gomp_malloc (2 * sizeof (struct gomp_task));
+  gomp_init_task (&thr->implicit_tasks[0], NULL, &gomp_global_icv);
+  gomp_init_task (&thr->implicit_tasks[1], NULL, &gomp_global_icv);
+}
+
 /* This function is a pthread_create entry point.  This contains the idle
    loop in which a thread waits to be called up to become part of a team.  */
 
@@ -74,6 +92,7 @@ gomp_thread_start (void *xdata)
   thr = &gomp_tls_data;
 #else
   struct gomp_thread local_thr;
+  memset (&local_thr, 0, sizeof (local_thr));
   thr = &local_thr;
   pthread_setspecific (gomp_tls_key, thr);
 #endif
@@ -99,13 +118,19 @@ gomp_thread_start (void *xdata)
 
       gomp_barrier_wait (&team->barrier);
 
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	gomp_tool_implicit_task_begin (team, thr->ts.team_id, local_fn);
       local_fn (local_data);
       gomp_team_barrier_wait_final (&team->barrier);
+      gomp_tool_event (gomp_tool_event_implicit_task_end, team,
+		       thr->ts.team_id, 0);
       gomp_finish_task (task);
       gomp_barrier_wait_last (&team->barrier);
     }
   else
     {
+      if (gomp_numa_local_var && thr->place && gomp_affinity_multinode_p ())
+	gomp_thread_numa_local (thr);
       pool->threads[thr->ts.team_id] = thr;
 
       gomp_barrier_wait (&pool->threads_dock);
@@ -114,9 +139,21 @@ gomp_thread_start (void *xdata)
 	  struct gomp_team *team = thr->ts.team;
 	  struct gomp_task *task = thr->task;
 
-	  local_fn (local_data);
-	  gomp_team_barrier_wait_final (&team->barrier);
-	  gomp_finish_task (task);
+	  /* Without a team, the thread only runs FN for its pool, see
+	     omp_pause_resource.  */
+	  if (__builtin_expect (team == NULL, 0))
+	    local_fn (local_data);
+	  else
+	    {
+	      if (__builtin_expect (gomp_tool_enabled, 0))
+		gomp_tool_implicit_task_begin (team, thr->ts.team_id,
+					       local_fn);
+	      local_fn (local_data);
+	      gomp_team_barrier_wait_final (&team->barrier);
+	      gomp_tool_event (gomp_tool_event_implicit_task_end, team,
+			       thr->ts.team_id, 0);
+	      gomp_finish_task (task);
+	    }
 
 	  gomp_barrier_wait (&pool->threads_dock);
 
@@ -130,10 +167,184 @@ gomp_thread_start (void *xdata)
   gomp_sem_destroy (&thr->release);
   thr->thread_pool = NULL;
   thr->task = NULL;
+  free (thr->implicit_tasks);
+  thr->implicit_tasks = NULL;
+  gomp_perf_free_thread (thr);
+  gomp_profile_free_thread (thr);
+  gomp_trace_free_thread (thr);
   return NULL;
 }
 
 
+/* Process-wide pool of workers lent to the top-level teams of all
+   threads, see GOMP_SHARED_POOL.  An idle worker sleeps on its WAKE
+   semaphore until a master hands it the start data of a team in DATA.
+   It then takes part in the team like the thread of a nested team.  */
+
+struct gomp_shared_worker
+{
+  struct gomp_shared_worker *next;
+  struct gomp_thread_start_data *data;
+  gomp_sem_t wake;
+};
+
+static gomp_mutex_t gomp_shared_pool_lock;
+/* Idle workers.  */
+static struct gomp_shared_worker *gomp_shared_pool_idle;
+/* Workers reserved by teams, out of gomp_shared_pool_var.  */
+static unsigned long gomp_shared_pool_busy;
+/* Number of teams holding workers.  */
+static unsigned long gomp_shared_pool_teams;
+
+static void *
+gomp_shared_worker_start (void *xdata)
+{
+  struct gomp_shared_worker *w = xdata;
+  struct gomp_thread *thr;
+
+#ifdef HAVE_TLS
+  thr = &gomp_tls_data;
+#else
+  struct gomp_thread local_thr;
+  memset (&local_thr, 0, sizeof (local_thr));
+  thr = &local_thr;
+  pthread_setspecific (gomp_tls_key, thr);
+#endif
+  gomp_sem_init (&thr->release, 0);
+
+  while (1)
+    {
+      struct gomp_thread_start_data *data;
+      struct gomp_team *team;
+      struct gomp_task *task;
+      void (*local_fn) (void *);
+      void *local_data;
+
+      /* DATA is on the stack of the master and must not be used once
+	 the team barrier releases it.  */
+      gomp_sem_wait (&w->wake);
+      data = w->data;
+      if (data == NULL)
+	break;
+      local_fn = data->fn;
+      local_data = data->fn_data;
+      thr->thread_pool = data->thread_pool;
+      thr->ts = data->ts;
+      thr->task = data->task;
+      thr->place = 0;
+      team = thr->ts.team;
+      task = thr->task;
+      team->ordered_release[thr->ts.team_id] = &thr->release;
+
+      gomp_barrier_wait (&team->barrier);
+      if (__builtin_expect (gomp_tool_enabled, 0))
+	gomp_tool_implicit_task_begin (team, thr->ts.team_id, local_fn);
+      local_fn (local_data);
+      gomp_team_barrier_wait_final (&team->barrier);
+      gomp_tool_event (gomp_tool_event_implicit_task_end, team,
+		       thr->ts.team_id, 0);
+      gomp_finish_task (task);
+      thr->ts.team = NULL;
+      thr->task = NULL;
+
+      /* Become idle before the master can leave gomp_team_end, so that
+	 its next team finds this worker free.  Another master may post
+	 WAKE right away; the team is not touched after the barrier.  */
+      gomp_mutex_lock (&gomp_shared_pool_lock);
+      w->next = gomp_shared_pool_idle;
+      gomp_shared_pool_idle = w;
+      gomp_shared_pool_busy--;
+      gomp_mutex_unlock (&gomp_shared_pool_lock);
+      gomp_barrier_wait_last (&team->barrier);
+    }
+
+  gomp_sem_destroy (&w->wake);
+  free (w);
+  gomp_sem_destroy (&thr->release);
+  gomp_perf_free_thread (thr);
+  gomp_profile_free_thread (thr);
+  gomp_trace_free_thread (thr);
+  return NULL;
+}
+
+/* Let the idle workers of the shared pool exit.  */
+
+static void
+gomp_shared_pool_free (void)
+{
+  struct gomp_shared_worker *w, *next;
+
+  gomp_mutex_lock (&gomp_shared_pool_lock);
+  w = gomp_shared_pool_idle;
+  gomp_shared_pool_idle = NULL;
+  gomp_mutex_unlock (&gomp_shared_pool_lock);
+
+  for (; w != NULL; w = next)
+    {
+      next = w->next;
+      w->data = NULL;
+      gomp_sem_post (&w->wake);
+    }
+}
+
+/* Let an idle worker of the shared pool, or a new one, run the start
+   DATA of a team.  The caller has reserved it.  */
+
+static void
+gomp_shared_pool_run (struct gomp_thread_start_data *data)
+{
+  struct gomp_shared_worker *w;
+
+  gomp_mutex_lock (&gomp_shared_pool_lock);
+  w = gomp_shared_pool_idle;
+  if (w != NULL)
+    gomp_shared_pool_idle = w->next;
+  gomp_mutex_unlock (&gomp_shared_pool_lock);
+
+  if (w == NULL)
+    {
+      pthread_t pt;
+      int err;
+
+      w = gomp_malloc (sizeof (*w));
+      gomp_sem_init (&w->wake, 0);
+      err = pthread_create (&pt, &gomp_thread_attr, gomp_shared_worker_start,
+			    w);
+      if (err != 0)
+	gomp_fatal ("Thread creation failed: %s", strerror (err));
+    }
+  w->data = data;
+  gomp_sem_post (&w->wake);
+}
+
+/* Reserve workers of the shared pool for a top-level team of at most
+   NTHREADS threads started by the calling thread and return its size.
+   A team gets at most its fair share of the pool, the pool divided
+   among the teams holding workers and this one, and no more workers
+   than are free, possibly none.  */
+
+unsigned
+gomp_shared_pool_reserve (unsigned nthreads)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  unsigned long share, n = nthreads - 1;
+
+  gomp_mutex_lock (&gomp_shared_pool_lock);
+  share = (gomp_shared_pool_var + gomp_shared_pool_teams)
+	  / (gomp_shared_pool_teams + 1);
+  if (n > share)
+    n = share;
+  if (n > gomp_shared_pool_var - gomp_shared_pool_busy)
+    n = gomp_shared_pool_var - gomp_shared_pool_busy;
+  gomp_shared_pool_busy += n;
+  if (n)
+    gomp_shared_pool_teams++;
+  gomp_mutex_unlock (&gomp_shared_pool_lock);
+
+  thr->shared_workers = n;
+  return n + 1;
+}
+
 /* Create a new team data structure.  */
 
 struct gomp_team *
@@ -170,12 +381,17 @@ gomp_new_team (unsigned nthreads)
   team->ordered_release[0] = &team->master_release;
 
   gomp_mutex_init (&team->task_lock);
-  team->task_queue = NULL;
+  team->task_queue.nonempty = 0;
+  team->task_queue.count = 0;
+  team->place_queues = NULL;
   team->task_count = 0;
   team->task_queued_count = 0;
   team->task_running_count = 0;
+  team->task_avg_ns = 0;
   team->work_share_cancelled = 0;
   team->team_cancelled = 0;
+  team->shared_pool = false;
+  team->tool_work_kind = -1;
 
   return team;
 }
@@ -188,6 +404,7 @@ free_team (struct gomp_team *team)
 {
   gomp_barrier_destroy (&team->barrier);
   gomp_mutex_destroy (&team->task_lock);
+  free (team->place_queues);
   free (team);
 }
 
@@ -204,6 +421,29 @@ static struct gomp_thread_pool *gomp_new_thread_pool (void)
   return pool;
 }
 
+/* With GOMP_PRESPAWN, the pool started in the background by
+   gomp_prespawn_start, until the first thread that needs a pool takes
+   it.  gomp_prespawn_lock is held while the pool is being started.  */
+static gomp_mutex_t gomp_prespawn_lock;
+static struct gomp_thread_pool *gomp_prespawn_pool;
+static bool gomp_prespawn_pending;
+
+/* Return the pool started for GOMP_PRESPAWN, waiting for it to be
+   complete, or NULL if it was already taken.  */
+
+static struct gomp_thread_pool *
+gomp_prespawn_take (void)
+{
+  struct gomp_thread_pool *pool;
+
+  gomp_mutex_lock (&gomp_prespawn_lock);
+  pool = gomp_prespawn_pool;
+  gomp_prespawn_pool = NULL;
+  __atomic_store_n (&gomp_prespawn_pending, false, MEMMODEL_RELAXED);
+  gomp_mutex_unlock (&gomp_prespawn_lock);
+  return pool;
+}
+
 static void
 gomp_free_pool_helper (void *thread_pool)
 {
@@ -214,15 +454,19 @@ gomp_free_pool_helper (void *thread_pool)
   gomp_sem_destroy (&thr->release);
   thr->thread_pool = NULL;
   thr->task = NULL;
+  free (thr->implicit_tasks);
+  thr->implicit_tasks = NULL;
+  gomp_perf_free_thread (thr);
+  gomp_profile_free_thread (thr);
+  gomp_trace_free_thread (thr);
   pthread_exit (NULL);
 }
 
-/* Free a thread pool and release its threads. */
+/* Free the thread pool of THR and release its threads.  */
 
 void
-gomp_free_thread (void *arg __attribute__((unused)))
+gomp_free_thread_pool (struct gomp_thread *thr)
 {
-  struct gomp_thread *thr = gomp_thread ();
   struct gomp_thread_pool *pool = thr->thread_pool;
   if (pool)
     {
@@ -258,6 +502,18 @@ gomp_free_thread (void *arg __attribute__((unused)))
       free (pool);
       thr->thread_pool = NULL;
     }
+}
+
+/* Free a thread pool and release its threads. */
+
+void
+gomp_free_thread (void *arg __attribute__((unused)))
+{
+  struct gomp_thread *thr = gomp_thread ();
+  gomp_free_thread_pool (thr);
+  gomp_perf_free_thread (thr);
+  gomp_profile_free_thread (thr);
+  gomp_trace_free_thread (thr);
   if (thr->task != NULL)
     {
       struct gomp_task *task = thr->task;
@@ -276,7 +532,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   struct gomp_thread *thr, *nthr;
   struct gomp_task *task;
   struct gomp_task_icv *icv;
-  bool nested;
+  bool nested, shared;
   struct gomp_thread_pool *pool;
   unsigned i, n, old_threads_used = 0;
   pthread_attr_t thread_attr, *attr;
@@ -287,10 +543,20 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   struct gomp_thread **affinity_thr = NULL;
 
   thr = gomp_thread ();
+  gomp_tool_event (gomp_tool_event_parallel_begin, team, nthreads,
+		   (unsigned long) fn);
   nested = thr->ts.team != NULL;
+  /* Workers reserved in the shared pool by gomp_resolve_num_threads.  */
+  shared = thr->shared_workers != 0;
+  thr->shared_workers = 0;
+  team->shared_pool = shared;
   if (__builtin_expect (thr->thread_pool == NULL, 0))
     {
-      thr->thread_pool = gomp_new_thread_pool ();
+      if (!nested && __atomic_load_n (&gomp_prespawn_pending,
+				      MEMMODEL_RELAXED))
+	thr->thread_pool = gomp_prespawn_take ();
+      if (thr->thread_pool == NULL)
+	thr->thread_pool = gomp_new_thread_pool ();
       thr->thread_pool->threads_busy = nthreads;
       pthread_setspecific (gomp_thread_destructor, thr);
     }
@@ -298,7 +564,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   task = thr->task;
   icv = task ? &task->icv : &gomp_global_icv;
   if (__builtin_expect (gomp_places_list != NULL, 0) && thr->place == 0)
-    gomp_init_affinity ();
+    gomp_init_master_affinity ();
 
   /* Always save the previous state, even if this isn't a nested team.
      In particular, we should save any work share state from an outer
@@ -331,6 +597,8 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   gomp_init_task (thr->task, task, icv);
   team->implicit_task[0].icv.nthreads_var = nthreads_var;
   team->implicit_task[0].icv.bind_var = bind_var;
+  if (__builtin_expect (gomp_tool_enabled, 0))
+    gomp_tool_implicit_task_begin (team, 0, fn);
 
   if (nthreads == 1)
     return;
@@ -404,13 +672,16 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
     }
   else
     bind = omp_proc_bind_false;
+  /* Workers of the shared pool are not bound.  */
+  if (shared)
+    bind = omp_proc_bind_false;
 
   /* We only allow the reuse of idle threads for non-nested PARALLEL
      regions.  This appears to be implied by the semantics of
      threadprivate variables, but perhaps that's reading too much into
      things.  Certainly it does prevent any locking problems, since
      only the initial program thread will modify gomp_threads.  */
-  if (!nested)
+  if (!nested && !shared)
     {
       old_threads_used = pool->threads_used;
 
@@ -597,11 +868,16 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
 	  nthr->ts.single_count = 0;
 #endif
 	  nthr->ts.static_trip = 0;
-	  nthr->task = &team->implicit_task[i];
+	  if (nthr->implicit_tasks == NULL)
+	    nthr->task = &team->implicit_task[i];
+	  else if (nthr->task == &nthr->implicit_tasks[0])
+	    nthr->task = &nthr->implicit_tasks[1];
+	  else
+	    nthr->task = &nthr->implicit_tasks[0];
 	  nthr->place = place;
 	  gomp_init_task (nthr->task, task, icv);
-	  team->implicit_task[i].icv.nthreads_var = nthreads_var;
-	  team->implicit_task[i].icv.bind_var = bind_var;
+	  nthr->task->icv.nthreads_var = nthreads_var;
+	  nthr->task->icv.bind_var = bind_var;
 	  nthr->fn = fn;
 	  nthr->data = data;
 	  team->ordered_release[i] = &nthr->release;
@@ -687,7 +963,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
     }
 
   attr = &gomp_thread_attr;
-  if (__builtin_expect (gomp_places_list != NULL, 0))
+  if (__builtin_expect (gomp_places_list != NULL, 0) && !shared)
     {
       size_t stacksize;
       pthread_attr_init (&thread_attr);
@@ -709,7 +985,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       start_data->ts.place_partition_off = thr->ts.place_partition_off;
       start_data->ts.place_partition_len = thr->ts.place_partition_len;
       start_data->place = 0;
-      if (__builtin_expect (gomp_places_list != NULL, 0))
+      if (__builtin_expect (gomp_places_list != NULL, 0) && !shared)
 	{
 	  switch (bind)
 	    {
@@ -792,16 +1068,21 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       start_data->thread_pool = pool;
       start_data->nested = nested;
 
+      if (shared)
+	{
+	  gomp_shared_pool_run (start_data++);
+	  continue;
+	}
       err = pthread_create (&pt, attr, gomp_thread_start, start_data++);
       if (err != 0)
 	gomp_fatal ("Thread creation failed: %s", strerror (err));
     }
 
-  if (__builtin_expect (gomp_places_list != NULL, 0))
+  if (__builtin_expect (gomp_places_list != NULL, 0) && !shared)
     pthread_attr_destroy (&thread_attr);
 
  do_release:
-  gomp_barrier_wait (nested ? &team->barrier : &pool->threads_dock);
+  gomp_barrier_wait (nested || shared ? &team->barrier : &pool->threads_dock);
 
   /* Decrease the barrier threshold to match the number of threads
      that should arrive back at the end of this team.  The extra
@@ -849,6 +1130,7 @@ gomp_team_end (void)
      team->barrier in a inconsistent state, we need to use a different
      counter here.  */
   gomp_team_barrier_wait_final (&team->barrier);
+  gomp_tool_event (gomp_tool_event_implicit_task_end, team, 0, 0);
   if (__builtin_expect (team->team_cancelled, 0))
     {
       struct gomp_work_share *ws = team->work_shares_to_free;
@@ -868,7 +1150,8 @@ gomp_team_end (void)
   gomp_end_task ();
   thr->ts = team->prev_ts;
 
-  if (__builtin_expect (thr->ts.team != NULL, 0))
+  if (__builtin_expect (thr->ts.team != NULL, 0)
+      || __builtin_expect (team->shared_pool, 0))
     {
 #ifdef HAVE_SYNC_BUILTINS
       __sync_fetch_and_add (&gomp_managed_threads, 1L - team->nthreads);
@@ -881,6 +1164,14 @@ gomp_team_end (void)
 	 and ensures the team can be safely destroyed.  */
       gomp_barrier_wait (&team->barrier);
     }
+  if (__builtin_expect (team->shared_pool, 0))
+    {
+      /* The workers are idle again, see gomp_shared_worker_start.  */
+      gomp_mutex_lock (&gomp_shared_pool_lock);
+      gomp_shared_pool_teams--;
+      gomp_mutex_unlock (&gomp_shared_pool_lock);
+    }
+  gomp_tool_event (gomp_tool_event_parallel_end, team, team->nthreads, 0);
 
   if (__builtin_expect (team->work_shares[0].next_alloc != NULL, 0))
     {
@@ -899,7 +1190,8 @@ gomp_team_end (void)
 #endif
 
   if (__builtin_expect (thr->ts.team != NULL, 0)
-      || __builtin_expect (team->nthreads == 1, 0))
+      || __builtin_expect (team->nthreads == 1, 0)
+      || __builtin_expect (team->shared_pool, 0))
     free_team (team);
   else
     {
@@ -914,8 +1206,10 @@ int profile_loop = -1;
 
 /* Constructors for this file.  */
 
-static void __attribute__((constructor))
-initialize_team (void)
+static pthread_once_t initialize_team_once = PTHREAD_ONCE_INIT;
+
+static void
+initialize_team_1 (void)
 {
 #ifndef HAVE_TLS
   static struct gomp_thread initial_thread_tls_data;
@@ -926,6 +1220,16 @@ initialize_team (void)
 
   if (pthread_key_create (&gomp_thread_destructor, gomp_free_thread) != 0)
     gomp_fatal ("could not create thread pool destructor.");
+
+#if !GOMP_MUTEX_INIT_0
+  gomp_mutex_init (&gomp_shared_pool_lock);
+#endif
+}
+
+static void __attribute__((constructor))
+initialize_team (void)
+{
+  pthread_once (&initialize_team_once, initialize_team_1);
 }
 
 static void __attribute__((destructor))
@@ -936,13 +1240,226 @@ team_destructor (void)
   pthread_key_delete (gomp_thread_destructor);
 }
 
+/* Have gomp_free_thread called when THR, the calling thread, exits, so
+   that what the runtime allocated for a thread it did not start, like
+   the buffers of the profiler, is released.  */
+
+void
+gomp_free_thread_at_exit (struct gomp_thread *thr)
+{
+  pthread_once (&initialize_team_once, initialize_team_1);
+  pthread_setspecific (gomp_thread_destructor, thr);
+}
+
 struct gomp_task_icv *
 gomp_new_icv (void)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_task *task = gomp_malloc (sizeof (struct gomp_task));
+  /* The task copies the global ICVs, which must be complete.  */
+  gomp_init_lazy ();
   gomp_init_task (task, NULL, &gomp_global_icv);
   thr->task = task;
   pthread_setspecific (gomp_thread_destructor, thr);
   return &task->icv;
 }
+
+static void
+gomp_pause_helper (void *thread_pool)
+{
+  struct gomp_thread_pool *pool = (struct gomp_thread_pool *) thread_pool;
+
+  gomp_release_stack ();
+  /* This barrier has a counterpart in omp_pause_resource.  */
+  gomp_barrier_wait (&pool->threads_dock);
+}
+
+/* Release the resources the runtime keeps between parallel regions.  A
+   soft pause keeps the threads of the pool of the calling thread but
+   gives the unused pages of their stacks and of the stacks of untied
+   tasks back to the system; a hard pause also lets the threads of that
+   pool and the idle workers of the shared pool exit and unmaps the
+   stacks.  Both free the cached team and the BinLPT task maps.  They are
+   created again when next needed.  */
+
+int
+omp_pause_resource (omp_pause_resource_t kind, int device_num)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_thread_pool *pool = thr->thread_pool;
+
+  if (device_num != gomp_get_num_devices ()
+      || (kind != omp_pause_soft && kind != omp_pause_hard)
+      || thr->ts.team != NULL)
+    return -1;
+
+  /* The pool started for GOMP_PRESPAWN is paused with that of the
+     caller.  */
+  if (pool == NULL && __atomic_load_n (&gomp_prespawn_pending,
+				       MEMMODEL_RELAXED))
+    {
+      pool = thr->thread_pool = gomp_prespawn_take ();
+      if (pool != NULL)
+	{
+	  pool->threads_busy = 1;
+	  pthread_setspecific (gomp_thread_destructor, thr);
+	}
+    }
+
+  if (kind == omp_pause_hard)
+    {
+      gomp_free_thread_pool (thr);
+      gomp_shared_pool_free ();
+      gomp_parallel_async_free ();
+    }
+  else if (pool != NULL && pool->threads_used > 1)
+    {
+      /* Let the docked threads of the pool trim their own stacks outside
+	 of any team, like gomp_free_thread_pool lets them exit.  */
+      unsigned i;
+      for (i = 1; i < pool->threads_used; i++)
+	{
+	  struct gomp_thread *nthr = pool->threads[i];
+	  nthr->ts.team = NULL;
+	  nthr->fn = gomp_pause_helper;
+	  nthr->data = pool;
+	}
+      /* This barrier undocks the threads, and this one waits till they
+	 are done with their stacks and with the last team.  */
+      gomp_barrier_wait (&pool->threads_dock);
+      gomp_barrier_wait (&pool->threads_dock);
+    }
+  if (kind == omp_pause_soft && pool != NULL && pool->last_team != NULL)
+    {
+      free_team (pool->last_team);
+      pool->last_team = NULL;
+    }
+  gomp_loop_taskmaps_free ();
+#ifdef GOMP_HAVE_TASK_CONTEXT
+  gomp_context_pool_release (kind == omp_pause_hard);
+#endif
+  return 0;
+}
+
+ialias (omp_pause_resource)
+
+int
+omp_pause_resource_all (omp_pause_resource_t kind)
+{
+  return ialias_call (omp_pause_resource) (kind, gomp_get_num_devices ());
+}
+
+/* A new thread only faults in the pages of its stack as it first uses
+   them; prewarming touches up to this much, or a quarter of the stack,
+   on every worker.  */
+#define GOMP_PREWARM_STACK (256 * 1024)
+
+static void
+gomp_prewarm_helper (void *data)
+{
+  size_t size = (size_t) data;
+
+  if (gomp_thread ()->ts.team_id != 0 && size != 0)
+    {
+      volatile char *p = gomp_alloca (size);
+      /* Downwards, as the stack grows, one store per 4 KiB.  */
+      while (size > 0)
+	{
+	  size = size > 4096 ? size - 4096 : 0;
+	  p[size] = 0;
+	}
+    }
+}
+
+/* Start and bind the threads that a top-level team of NTHREADS threads,
+   or of the nthreads-var ICV if NTHREADS is 0, would use and fault in
+   their stacks, all workers at once.  */
+
+static int
+gomp_prewarm (unsigned long nthreads)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_task_icv *icv = gomp_icv (false);
+  unsigned long n = nthreads != 0 ? nthreads : icv->nthreads_var;
+  size_t stacksize = 0;
+
+  if (thr->ts.team != NULL)
+    return -1;
+
+  if (n > icv->thread_limit_var)
+    n = icv->thread_limit_var;
+  if (gomp_shared_pool_var != 0 && n > 1)
+    n = gomp_shared_pool_reserve (n);
+  if (n > 1)
+    {
+      pthread_attr_getstacksize (&gomp_thread_attr, &stacksize);
+      stacksize /= 4;
+      if (stacksize > GOMP_PREWARM_STACK)
+	stacksize = GOMP_PREWARM_STACK;
+      gomp_team_start (gomp_prewarm_helper, (void *) stacksize, n, 0,
+		       gomp_new_team (n));
+      gomp_team_end ();
+    }
+  return 0;
+}
+
+int
+GOMP_prewarm (int nthreads)
+{
+  return gomp_prewarm (nthreads > 0 ? nthreads : 0);
+}
+
+/* The helper thread of gomp_prespawn.  It starts a pool of its own, with
+   the same ICVs as any thread that has not changed them yet, and leaves
+   it for the first thread that needs one.  */
+
+static void *
+gomp_prespawn_start (void *arg __attribute__((unused)))
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  pthread_once (&initialize_team_once, initialize_team_1);
+  /* Have gomp_team_start use this pool rather than wait for itself.  */
+  thr->thread_pool = gomp_new_thread_pool ();
+  thr->thread_pool->threads_busy = 1;
+  gomp_prewarm (gomp_prespawn_var != ULONG_MAX ? gomp_prespawn_var : 0);
+  gomp_prespawn_pool = thr->thread_pool;
+  thr->thread_pool = NULL;
+  gomp_mutex_unlock (&gomp_prespawn_lock);
+  return NULL;
+}
+
+/* A child created by fork has none of the threads of the pool, and
+   nobody to release the lock if it was still being started.  */
+
+static void
+gomp_prespawn_atfork_child (void)
+{
+  gomp_mutex_init (&gomp_prespawn_lock);
+  gomp_prespawn_pool = NULL;
+  gomp_prespawn_pending = false;
+}
+
+/* Start the pool of GOMP_PRESPAWN in the background, once the library
+   is loaded, so that neither the loading nor the first region waits
+   for the threads to be created.  */
+
+void
+gomp_prespawn (void)
+{
+  pthread_attr_t attr;
+  pthread_t thread;
+
+  gomp_mutex_init (&gomp_prespawn_lock);
+  gomp_mutex_lock (&gomp_prespawn_lock);
+  gomp_prespawn_pending = true;
+  pthread_atfork (NULL, NULL, gomp_prespawn_atfork_child);
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create (&thread, &attr, gomp_prespawn_start, NULL) != 0)
+    {
+      gomp_prespawn_pending = false;
+      gomp_mutex_unlock (&gomp_prespawn_lock);
+    }
+  pthread_attr_destroy (&attr);
+}
@@ -0,0 +1,79 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-ldl" { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_DYNAMIC "true" } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "8" } */
+/* { dg-set-target-env-var GOMP_ADAPTIVE_TEAMS "true" } */
+/* { dg-set-target-env-var OMP_WAIT_POLICY "passive" } */
+
+#include "cpu-quota.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct fake_file fake_files[] = { { NULL, NULL } };
+
+/* Run a region whose master sleeps longer the more threads it has.  */
+
+static int
+slower (void)
+{
+  int n;
+
+  #pragma omp parallel
+  #pragma omp master
+  {
+    n = omp_get_num_threads ();
+    usleep (5000 * n);
+  }
+  return n;
+}
+
+/* Run a region whose threads sleep longer the fewer they are.  */
+
+static int
+faster (void)
+{
+  int n;
+
+  #pragma omp parallel
+  {
+    #pragma omp master
+    n = omp_get_num_threads ();
+    usleep (160000 / omp_get_num_threads ());
+  }
+  return n;
+}
+
+int
+main (void)
+{
+  static const int slower_sizes[12] = { 8, 8, 8, 4, 4, 4, 2, 2, 2, 1, 1, 1 };
+  static const int faster_sizes[6] = { 8, 8, 8, 4, 4, 4 };
+  int i, n;
+
+  /* Each construct is timed with halved team sizes as long as it gets
+     faster, and then uses the fastest size.  */
+  for (i = 0; i < 20; i++)
+    if (slower () != (i < 12 ? slower_sizes[i] : 1))
+      abort ();
+  for (i = 0; i < 10; i++)
+    if (faster () != (i < 6 ? faster_sizes[i] : 8))
+      abort ();
+
+  /* Regions with a num_threads clause are left alone.  */
+  for (i = 0; i < 5; i++)
+    {
+      #pragma omp parallel num_threads (8)
+      #pragma omp master
+      n = omp_get_num_threads ();
+      if (n != 8)
+	abort ();
+    }
+
+  /* The search starts again when nthreads-var changes.  */
+  omp_set_num_threads (2);
+  for (i = 0; i < 10; i++)
+    if (faster () != (i >= 3 && i < 6 ? 1 : 2))
+      abort ();
+  return 0;
+}
@@ -0,0 +1,44 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-ldl" { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_DYNAMIC "true" } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "8" } */
+/* { dg-set-target-env-var GOMP_ADAPTIVE_TEAMS "true" } */
+/* { dg-set-target-env-var GOMP_SHARED_POOL "1" } */
+/* { dg-set-target-env-var OMP_WAIT_POLICY "passive" } */
+
+#include "cpu-quota.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct fake_file fake_files[] = { { NULL, NULL } };
+
+/* Run a region whose master sleeps longer the more threads it has.  */
+
+static int
+slower (void)
+{
+  int n;
+
+  #pragma omp parallel
+  #pragma omp master
+  {
+    n = omp_get_num_threads ();
+    usleep (5000 * n);
+  }
+  return n;
+}
+
+int
+main (void)
+{
+  int i;
+
+  /* The shared pool only lends one worker, so the runs are timed with
+     the 2 threads they get rather than with the 8 and 4 asked for, and
+     a single thread is found to be faster.  */
+  for (i = 0; i < 10; i++)
+    if (slower () != (i < 3 ? 2 : 1))
+      abort ();
+  return 0;
+}
@@ -0,0 +1,170 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_PROC_BIND "true" } */
+/* { dg-set-target-env-var OMP_PLACES "ll_caches" } */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <omp.h>
+#include <dirent.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SYSFS "/sys/devices/system"
+
+cpu_set_t initial;
+
+/* Read the CPU list in the file at PATH, like 0-3,8, into SET.  Return
+   0 if there is none.  */
+
+static int
+read_cpulist (const char *path, cpu_set_t *set)
+{
+  char buf[4096], *p;
+  FILE *f = fopen (path, "r");
+  int ret;
+
+  CPU_ZERO (set);
+  if (f == NULL)
+    return 0;
+  ret = fgets (buf, sizeof (buf), f) != NULL;
+  fclose (f);
+  for (p = buf; ret && *p >= '0' && *p <= '9'; )
+    {
+      unsigned long lo = strtoul (p, &p, 10), hi = lo;
+      if (*p == '-')
+	hi = strtoul (p + 1, &p, 10);
+      for (; lo <= hi && lo < CPU_SETSIZE; lo++)
+	CPU_SET (lo, set);
+      if (*p == ',')
+	p++;
+    }
+  return ret;
+}
+
+/* Set SET to the CPUs sharing the last level cache with CPU.  */
+
+static int
+cache_cpus (int cpu, cpu_set_t *set)
+{
+  char path[128], type[32];
+  int index, level, best = 0;
+  FILE *f;
+
+  for (index = 0; ; index++)
+    {
+      sprintf (path, SYSFS "/cpu/cpu%d/cache/index%d/level", cpu, index);
+      f = fopen (path, "r");
+      if (f == NULL)
+	break;
+      if (fscanf (f, "%d", &level) != 1)
+	level = 0;
+      fclose (f);
+      sprintf (path, SYSFS "/cpu/cpu%d/cache/index%d/type", cpu, index);
+      f = fopen (path, "r");
+      if (f && fgets (type, sizeof (type), f)
+	  && strncmp (type, "Instruction", 11) == 0)
+	level = 0;
+      if (f)
+	fclose (f);
+      if (level < 2 || level > 3 || level <= best)
+	continue;
+      sprintf (path, SYSFS "/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu,
+	       index);
+      if (read_cpulist (path, set))
+	best = level;
+    }
+  if (best)
+    return 1;
+  sprintf (path, SYSFS "/cpu/cpu%d/topology/thread_siblings_list", cpu);
+  return read_cpulist (path, set);
+}
+
+/* Set SET to the CPUs on the NUMA node of CPU.  */
+
+static int
+node_cpus (int cpu, cpu_set_t *set)
+{
+  struct dirent *ent;
+  char path[sizeof (SYSFS "/node//cpulist") + sizeof (ent->d_name)];
+  DIR *dir;
+  int ret = 0;
+
+  sprintf (path, SYSFS "/cpu/cpu%d", cpu);
+  dir = opendir (path);
+  if (dir == NULL)
+    return 0;
+  while ((ent = readdir (dir)) != NULL)
+    if (strncmp (ent->d_name, "node", 4) == 0
+	&& ent->d_name[4] >= '0' && ent->d_name[4] <= '9')
+      {
+	sprintf (path, SYSFS "/node/%s/cpulist", ent->d_name);
+	ret = read_cpulist (path, set);
+	break;
+      }
+  closedir (dir);
+  return ret;
+}
+
+int
+main (void)
+{
+  const char *places = getenv ("OMP_PLACES");
+  int numa = places && strcmp (places, "numa_domains") == 0;
+  int bad = 0;
+
+  if (sched_getaffinity (0, sizeof (initial), &initial) != 0)
+    return 0;
+
+  /* Each thread is bound to the CPUs it may run on that share its last
+     level cache, or its NUMA node.  */
+  #pragma omp parallel
+  {
+    cpu_set_t mask, expected;
+    int cpu;
+
+    if (sched_getaffinity (0, sizeof (mask), &mask) != 0)
+      abort ();
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET (cpu, &mask))
+	break;
+    if (cpu == CPU_SETSIZE)
+      abort ();
+    if (numa ? node_cpus (cpu, &expected) : cache_cpus (cpu, &expected))
+      {
+	CPU_AND (&expected, &expected, &initial);
+	if (!CPU_EQUAL (&mask, &expected))
+	  #pragma omp atomic write
+	  bad = 1;
+      }
+  }
+  if (bad)
+    abort ();
+
+  if (!numa)
+    {
+      int status;
+      pid_t pid;
+
+      if (setenv ("OMP_PLACES", "numa_domains", 1) != 0)
+	return 0;
+      pid = fork ();
+      if (pid == -1)
+	return 0;
+      if (pid == 0)
+	{
+	  execl ("/proc/self/exe", "affinity-2.exe", NULL);
+	  _exit (0);
+	}
+      if (waitpid (pid, &status, 0) < 0)
+	return 0;
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+	abort ();
+    }
+  return 0;
+}
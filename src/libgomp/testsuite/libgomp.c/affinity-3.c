@@ -0,0 +1,145 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_PROC_BIND "true" } */
+
+/* The machine described below affinity-3-sysfs has 8 CPUs on one
+   socket, 2 NUMA nodes of 4 CPUs and 4 last level caches shared by 2
+   CPUs each.  The runtime is made to read it with GOMP_TOPOLOGY_ROOT, and
+   to believe all its CPUs are available.  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct places
+{
+  const char *name;
+  int count;
+  unsigned long places[8];
+} places_array[] = {
+  { "cores", 8, { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 } },
+  { "ll_caches", 4, { 0x03, 0x0c, 0x30, 0xc0 } },
+  { "numa_domains", 2, { 0x0f, 0xf0 } },
+  { "sockets", 1, { 0xff } }
+};
+
+/* The CPU sets the threads got bound to.  */
+unsigned long bound[64];
+int nbound;
+
+static unsigned long
+to_mask (size_t size, const cpu_set_t *set)
+{
+  unsigned long mask = 0;
+  int i;
+
+  for (i = 0; i < 64 && i < 8 * (int) size; i++)
+    if (CPU_ISSET_S (i, size, set))
+      mask |= 1UL << i;
+  return mask;
+}
+
+int
+pthread_getaffinity_np (pthread_t thread, size_t size, cpu_set_t *set)
+{
+  int i;
+
+  (void) thread;
+  CPU_ZERO_S (size, set);
+  for (i = 0; i < 8; i++)
+    CPU_SET_S (i, size, set);
+  return 0;
+}
+
+int
+pthread_setaffinity_np (pthread_t thread, size_t size, const cpu_set_t *set)
+{
+  (void) thread;
+  if (nbound < 64)
+    bound[nbound++] = to_mask (size, set);
+  return 0;
+}
+
+int
+pthread_attr_setaffinity_np (pthread_attr_t *attr, size_t size,
+			     const cpu_set_t *set)
+{
+  (void) attr;
+  if (nbound < 64)
+    bound[nbound++] = to_mask (size, set);
+  return 0;
+}
+
+static void
+check (struct places *p)
+{
+  int i, j;
+
+  /* Spreading one thread per place binds each to a different place.  */
+  #pragma omp parallel num_threads (p->count) proc_bind (spread)
+  if (omp_get_num_threads () != p->count)
+    abort ();
+
+  if (nbound != p->count)
+    abort ();
+  for (i = 0; i < p->count; i++)
+    {
+      for (j = 0; j < nbound; j++)
+	if (bound[j] == p->places[i])
+	  break;
+      if (j == nbound)
+	abort ();
+    }
+}
+
+int
+main (void)
+{
+  const char *env = getenv ("OMP_PLACES");
+  char *root;
+  size_t i, len;
+
+  if (getenv ("GOMP_TOPOLOGY_ROOT") != NULL)
+    {
+      for (i = 0; i < sizeof (places_array) / sizeof (places_array[0]); i++)
+	if (env && strcmp (env, places_array[i].name) == 0)
+	  check (&places_array[i]);
+      return 0;
+    }
+
+  len = strrchr (__FILE__, '/') ? strrchr (__FILE__, '/') - __FILE__ + 1 : 0;
+  root = malloc (len + sizeof ("affinity-3-sysfs"));
+  memcpy (root, __FILE__, len);
+  strcpy (root + len, "affinity-3-sysfs");
+  if (access (root, R_OK) != 0 || setenv ("GOMP_TOPOLOGY_ROOT", root, 1) < 0)
+    return 0;
+
+  for (i = 0; i < sizeof (places_array) / sizeof (places_array[0]); i++)
+    {
+      int status;
+      pid_t pid;
+
+      if (setenv ("OMP_PLACES", places_array[i].name, 1) < 0)
+	break;
+      pid = fork ();
+      if (pid == -1)
+	break;
+      if (pid == 0)
+	{
+	  execl ("/proc/self/exe", "affinity-3.exe", NULL);
+	  _exit (0);
+	}
+      if (waitpid (pid, &status, 0) < 0)
+	break;
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+	abort ();
+    }
+  return 0;
+}
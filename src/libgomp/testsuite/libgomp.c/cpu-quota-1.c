@@ -0,0 +1,45 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-ldl" { target *-*-linux* } } */
+
+#include "cpu-quota.h"
+#include <omp.h>
+#include <stdlib.h>
+
+/* A cgroup v2 hierarchy, where the parent of the group of the process has
+   a quota of 2.5 CPUs.  */
+struct fake_file fake_files[] = {
+  { "/proc/self/cgroup", "0::/job/step\n" },
+  { "/sys/fs/cgroup/job/step/cpu.max", "max 100000\n" },
+  { "/sys/fs/cgroup/job/cpu.max", "250000 100000\n" },
+  { "/sys/fs/cgroup/cpu.max", "max 100000\n" },
+  { NULL, NULL }
+};
+
+int
+main (void)
+{
+  int n;
+
+  if (omp_get_num_procs () != 3)
+    abort ();
+  if (getenv ("OMP_NUM_THREADS") == NULL && omp_get_max_threads () != 3)
+    abort ();
+
+  omp_set_dynamic (1);
+  #pragma omp parallel num_threads (8)
+  #pragma omp single
+  n = omp_get_num_threads ();
+  if (n != 3)
+    abort ();
+
+  /* The quota is read again when choosing the size of a team.  */
+  fake_files[1].contents = "50000 100000\n";
+  if (omp_get_num_procs () != 1)
+    abort ();
+  #pragma omp parallel num_threads (8)
+  #pragma omp single
+  n = omp_get_num_threads ();
+  if (n != 1)
+    abort ();
+  return 0;
+}
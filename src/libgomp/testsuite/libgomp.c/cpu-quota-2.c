@@ -0,0 +1,29 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-ldl" { target *-*-linux* } } */
+
+#include "cpu-quota.h"
+#include <omp.h>
+#include <stdlib.h>
+
+/* A cgroup v1 hierarchy, where the group of the process has a quota of
+   2 CPUs.  */
+struct fake_file fake_files[] = {
+  { "/proc/self/cgroup",
+    "12:memory:/other\n4:cpu,cpuacct:/batch\n0::/unified\n" },
+  { "/sys/fs/cgroup/cpu/batch/cpu.cfs_quota_us", "200000\n" },
+  { "/sys/fs/cgroup/cpu/batch/cpu.cfs_period_us", "100000\n" },
+  { "/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "-1\n" },
+  { "/sys/fs/cgroup/cpu/cpu.cfs_period_us", "100000\n" },
+  { "/sys/fs/cgroup/unified/cpu.max", "100000 100000\n" },
+  { NULL, NULL }
+};
+
+int
+main (void)
+{
+  if (omp_get_num_procs () != 2)
+    abort ();
+  if (getenv ("OMP_NUM_THREADS") == NULL && omp_get_max_threads () != 2)
+    abort ();
+  return 0;
+}
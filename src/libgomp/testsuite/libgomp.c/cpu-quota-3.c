@@ -0,0 +1,24 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-ldl" { target *-*-linux* } } */
+/* { dg-set-target-env-var GOMP_CPU_QUOTA "false" } */
+
+#include "cpu-quota.h"
+#include <omp.h>
+#include <stdlib.h>
+
+struct fake_file fake_files[] = {
+  { "/proc/self/cgroup", "0::/\n" },
+  { "/sys/fs/cgroup/cpu.max", "100000 100000\n" },
+  { NULL, NULL }
+};
+
+int
+main (void)
+{
+  /* The quota is ignored.  */
+  if (omp_get_num_procs () != 8)
+    abort ();
+  if (getenv ("OMP_NUM_THREADS") == NULL && omp_get_max_threads () != 8)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,92 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_PROC_BIND "true" } */
+/* { dg-set-target-env-var OMP_PLACES "{0},{1},{2},{3}" } */
+
+/* The runtime must not query the CPUs available nor build the places
+   before it is first used, and the thread which happens to use it first
+   must not be bound unless it starts a team.  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+int ngetaffinity, nsetaffinity, nattraffinity;
+pthread_t main_thread, bound_thread;
+
+int
+pthread_getaffinity_np (pthread_t thread, size_t size, cpu_set_t *set)
+{
+  int i;
+
+  (void) thread;
+  __atomic_fetch_add (&ngetaffinity, 1, __ATOMIC_RELAXED);
+  CPU_ZERO_S (size, set);
+  for (i = 0; i < 4; i++)
+    CPU_SET_S (i, size, set);
+  return 0;
+}
+
+int
+pthread_setaffinity_np (pthread_t thread, size_t size, const cpu_set_t *set)
+{
+  (void) size;
+  (void) set;
+  __atomic_fetch_add (&nsetaffinity, 1, __ATOMIC_RELAXED);
+  bound_thread = thread;
+  return 0;
+}
+
+int
+pthread_attr_setaffinity_np (pthread_attr_t *attr, size_t size,
+			     const cpu_set_t *set)
+{
+  (void) attr;
+  (void) size;
+  (void) set;
+  __atomic_fetch_add (&nattraffinity, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+static void *
+query (void *arg)
+{
+  (void) arg;
+  if (omp_get_max_threads () != 4
+      || omp_get_proc_bind () != omp_proc_bind_true)
+    abort ();
+  return NULL;
+}
+
+int
+main (void)
+{
+  pthread_t thread;
+
+  /* Nothing has used the runtime yet.  */
+  if (ngetaffinity != 0 || nsetaffinity != 0 || nattraffinity != 0)
+    abort ();
+
+  /* Another thread uses it first.  It initializes the runtime, but
+     starts no team, so no thread gets bound.  */
+  main_thread = pthread_self ();
+  if (pthread_create (&thread, NULL, query, NULL) != 0
+      || pthread_join (thread, NULL) != 0)
+    abort ();
+  if (ngetaffinity == 0 || nsetaffinity != 0 || nattraffinity != 0)
+    abort ();
+
+  /* The master of the first team is bound, and so are the threads it
+     starts.  */
+  #pragma omp parallel num_threads (4)
+  if (omp_get_num_threads () != 4)
+    abort ();
+  if (nsetaffinity != 1
+      || !pthread_equal (bound_thread, main_thread)
+      || nattraffinity != 3)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,79 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var GOMP_NODE_BUDGET "6" } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Run this program again as a process sharing the node, expecting its
+   regions without a num_threads clause to get EXPECTED threads.  */
+
+static void
+run_child (const char *expected)
+{
+  int status;
+  pid_t pid;
+
+  if (setenv ("NODE_BUDGET_CHILD", expected, 1) < 0)
+    abort ();
+  pid = fork ();
+  if (pid == -1)
+    abort ();
+  if (pid == 0)
+    {
+      execl ("/proc/self/exe", "node-budget-1.exe", NULL);
+      _exit (1);
+    }
+  if (waitpid (pid, &status, 0) < 0
+      || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    abort ();
+}
+
+int
+main (void)
+{
+  const char *child = getenv ("NODE_BUDGET_CHILD");
+  char name[64];
+  struct stat st;
+  int n;
+
+  if (child)
+    {
+      #pragma omp parallel
+      #pragma omp master
+      n = omp_get_num_threads ();
+      if (n != atoi (child))
+	return 1;
+      #pragma omp parallel num_threads (4)
+      #pragma omp master
+      n = omp_get_num_threads ();
+      return n != 4;
+    }
+
+  sprintf (name, "/dev/shm/libgomp-budget.%lu", (unsigned long) getuid ());
+  if (omp_get_max_threads () != 4 || stat (name, &st) != 0)
+    return 0;
+
+  /* While this process runs 4 threads, another one gets only the 2 left
+     of the budget, less its initial thread.  Once this process is back
+     to its initial thread, it gets all it asks for.  */
+  #pragma omp parallel
+  #pragma omp master
+  run_child ("2");
+  run_child ("4");
+
+  /* The budget is ignored unless only the user can access the file.  */
+  if (chmod (name, 0644) != 0)
+    abort ();
+  #pragma omp parallel
+  #pragma omp master
+  run_child ("4");
+  if (chmod (name, 0600) != 0)
+    abort ();
+  return 0;
+}
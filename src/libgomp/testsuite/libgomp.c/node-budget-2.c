@@ -0,0 +1,63 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var GOMP_NODE_BUDGET "4" } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Top-level teams started at the same time by several threads of a
+   process share its part of the budget.  */
+
+static pthread_barrier_t bar;
+
+static void *
+team (void *arg)
+{
+  int *n = (int *) arg;
+
+  #pragma omp parallel
+  #pragma omp master
+  {
+    *n = omp_get_num_threads ();
+    /* Both teams are running.  */
+    pthread_barrier_wait (&bar);
+  }
+  return NULL;
+}
+
+int
+main (void)
+{
+  pthread_t thread[2];
+  int n[2] = { 0, 0 }, i;
+  char name[64];
+  struct stat st;
+
+  sprintf (name, "/dev/shm/libgomp-budget.%lu", (unsigned long) getuid ());
+  if (omp_get_max_threads () != 4 || stat (name, &st) != 0)
+    return 0;
+
+  pthread_barrier_init (&bar, NULL, 2);
+  for (i = 0; i < 2; i++)
+    if (pthread_create (&thread[i], NULL, team, &n[i]) != 0)
+      abort ();
+  for (i = 0; i < 2; i++)
+    pthread_join (thread[i], NULL);
+
+  /* The initial thread and the 3 workers of one team use up the budget,
+     so the other team only has its own thread.  */
+  if (n[0] < 1 || n[1] < 1 || n[0] + n[1] > 5)
+    abort ();
+
+  /* Once both have ended, a team gets all the budget again.  */
+  pthread_barrier_destroy (&bar);
+  pthread_barrier_init (&bar, NULL, 1);
+  team (&n[0]);
+  if (n[0] != 4)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,39 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_PROC_BIND "spread" } */
+/* { dg-set-target-env-var OMP_PLACES "{0},{0},{0},{0}" } */
+/* { dg-set-target-env-var GOMP_NUMA_LOCAL "true" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int
+main (void)
+{
+  int i, n, sum, bad = 0;
+
+  /* Teams of changing sizes reuse the threads of the pool, each setting
+     the ICVs of its own implicit task.  When the places span several NUMA
+     nodes, the threads allocate these implicit tasks themselves.  */
+  for (i = 0; i < 50; i++)
+    {
+      n = 1 + i % 4;
+      sum = 0;
+      #pragma omp parallel num_threads (n) reduction (+:sum)
+      {
+	int id = omp_get_thread_num ();
+	omp_set_num_threads (id + 2);
+	#pragma omp task
+	if (omp_get_max_threads () != id + 2)
+	  #pragma omp atomic write
+	  bad = 1;
+	#pragma omp barrier
+	if (omp_get_num_threads () != n || omp_get_max_threads () != id + 2)
+	  #pragma omp atomic write
+	  bad = 1;
+	sum += id;
+      }
+      if (bad || sum != n * (n - 1) / 2 || omp_get_max_threads () != 4)
+	abort ();
+    }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+pthread_t caller;
+int go, size, level, count, mask;
+
+static void
+fn (void *data)
+{
+  int *arrived = data;
+
+  if (pthread_equal (pthread_self (), caller))
+    abort ();
+  while (!__atomic_load_n (&go, __ATOMIC_ACQUIRE))
+    ;
+  #pragma omp atomic
+  mask |= 1 << omp_get_thread_num ();
+  #pragma omp master
+  {
+    size = omp_get_num_threads ();
+    level = omp_get_level ();
+  }
+  if (arrived != NULL)
+    {
+      /* Wait for all the threads of both regions.  */
+      __atomic_fetch_add (arrived, 1, __ATOMIC_RELAXED);
+      while (__atomic_load_n (arrived, __ATOMIC_RELAXED) != 4)
+	;
+    }
+  #pragma omp atomic
+  count++;
+}
+
+static void
+run (int num_threads, int expected)
+{
+  gomp_parallel_handle_t h;
+
+  go = 0;
+  size = level = count = mask = 0;
+  h = GOMP_parallel_async (fn, NULL, num_threads);
+
+  /* The region can not end before the caller lets it.  */
+  if (GOMP_parallel_test (h))
+    abort ();
+  __atomic_store_n (&go, 1, __ATOMIC_RELEASE);
+  while (!GOMP_parallel_test (h))
+    ;
+  GOMP_parallel_wait (h);
+  if (size != expected || level != 1 || count != expected
+      || mask != (1 << expected) - 1)
+    abort ();
+}
+
+int
+main (void)
+{
+  gomp_parallel_handle_t h1, h2;
+  int i, arrived = 0;
+
+  caller = pthread_self ();
+  run (2, 2);
+  run (0, 4);
+
+  /* The region gets the ICVs of the caller.  */
+  omp_set_num_threads (3);
+  run (0, 3);
+  run (-1, 3);
+
+  /* Drivers are reused.  */
+  for (i = 0; i < 20; i++)
+    run (i % 4 + 1, i % 4 + 1);
+
+  /* Two regions run at the same time.  */
+  count = 0;
+  __atomic_store_n (&go, 1, __ATOMIC_RELEASE);
+  h1 = GOMP_parallel_async (fn, &arrived, 2);
+  h2 = GOMP_parallel_async (fn, &arrived, 2);
+  GOMP_parallel_wait (h2);
+  GOMP_parallel_wait (h1);
+  if (count != 4)
+    abort ();
+
+  /* The caller can still run parallel regions of its own meanwhile.  */
+  go = 0;
+  count = 0;
+  h1 = GOMP_parallel_async (fn, NULL, 2);
+  #pragma omp parallel num_threads (2)
+  if (omp_get_num_threads () != 2)
+    abort ();
+  __atomic_store_n (&go, 1, __ATOMIC_RELEASE);
+  GOMP_parallel_wait (h1);
+  if (count != 2)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,80 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+/* The drivers of asynchronous regions and their thread pools are freed
+   by a hard pause, but only once the regions have ended.  */
+
+#include <omp.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Return the number of threads of the process, waiting up to a second
+   for it to become EXPECTED.  */
+
+static int
+num_threads (int expected)
+{
+  int i, n = 0;
+
+  for (i = 0; i < 100; i++)
+    {
+      DIR *dir = opendir ("/proc/self/task");
+      struct dirent *ent;
+
+      if (dir == NULL)
+	exit (0);
+      n = 0;
+      while ((ent = readdir (dir)) != NULL)
+	n += ent->d_name[0] != '.';
+      closedir (dir);
+      if (n == expected)
+	break;
+      usleep (10000);
+    }
+  return n;
+}
+
+static void
+fn (void *data)
+{
+  #pragma omp atomic
+  *(int *) data += 1;
+}
+
+int
+main (void)
+{
+  gomp_parallel_handle_t h;
+  int count = 0;
+
+  if (num_threads (1) != 1)
+    abort ();
+
+  /* The driver and its 3 other threads.  */
+  h = GOMP_parallel_async (fn, &count, 4);
+  while (!GOMP_parallel_test (h))
+    ;
+  if (count != 4 || num_threads (5) != 5)
+    abort ();
+
+  /* Until it is waited for, a hard pause only frees the pool.  */
+  if (omp_pause_resource_all (omp_pause_hard) != 0 || num_threads (2) != 2)
+    abort ();
+  GOMP_parallel_wait (h);
+  if (num_threads (2) != 2)
+    abort ();
+
+  /* The idle driver is reused, and starts a new pool.  */
+  h = GOMP_parallel_async (fn, &count, 3);
+  GOMP_parallel_wait (h);
+  if (count != 7 || num_threads (4) != 4)
+    abort ();
+
+  /* A soft pause keeps it.  */
+  if (omp_pause_resource_all (omp_pause_soft) != 0 || num_threads (4) != 4)
+    abort ();
+  if (omp_pause_resource_all (omp_pause_hard) != 0 || num_threads (1) != 1)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+#include <omp.h>
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern bool GOMP_loop_runtime_start (long, long, long, long *, long *);
+extern bool GOMP_loop_runtime_next (long *, long *);
+extern void GOMP_loop_end (void);
+
+static unsigned workload[8] = { 10, 1, 1, 1, 1, 1, 1, 4 };
+
+/* Return the number of threads of the process, waiting up to a second
+   for it to become EXPECTED.  */
+
+static int
+num_threads (int expected)
+{
+  int i, n = 0;
+
+  for (i = 0; i < 100; i++)
+    {
+      DIR *dir = opendir ("/proc/self/task");
+      struct dirent *ent;
+
+      if (dir == NULL)
+	exit (0);
+      n = 0;
+      while ((ent = readdir (dir)) != NULL)
+	n += ent->d_name[0] != '.';
+      closedir (dir);
+      if (n == expected)
+	break;
+      usleep (10000);
+    }
+  return n;
+}
+
+static int
+region (void)
+{
+  int n = 0;
+
+  #pragma omp parallel reduction (+:n)
+  n++;
+  return n;
+}
+
+/* Return the sum of the workload over a loop with the BinLPT schedule,
+   whose iteration mapping pauses free.  */
+
+static unsigned
+binlpt_loop (void)
+{
+  unsigned n = 0;
+
+  #pragma omp parallel reduction (+:n)
+  {
+    long s, e, i;
+
+    if (GOMP_loop_runtime_start (0, 8, 1, &s, &e))
+      do
+	for (i = s; i < e; i++)
+	  n += workload[i];
+      while (GOMP_loop_runtime_next (&s, &e));
+    GOMP_loop_end ();
+  }
+  return n;
+}
+
+int
+main (void)
+{
+  int host = omp_get_num_devices (), ret = 0;
+
+  if (num_threads (1) != 1)
+    abort ();
+  if (region () != 4 || num_threads (4) != 4)
+    abort ();
+
+  /* A soft pause keeps the threads, a hard one makes them exit.  */
+  if (omp_pause_resource (omp_pause_soft, host) != 0 || num_threads (4) != 4)
+    abort ();
+  if (region () != 4)
+    abort ();
+  if (omp_pause_resource (omp_pause_hard, host) != 0 || num_threads (1) != 1)
+    abort ();
+  if (region () != 4 || num_threads (4) != 4)
+    abort ();
+  if (omp_pause_resource_all (omp_pause_hard) != 0 || num_threads (1) != 1)
+    abort ();
+
+  if (omp_pause_resource (omp_pause_hard, host + 1) == 0
+      || omp_pause_resource ((omp_pause_resource_t) 7, host) == 0
+      || omp_pause_resource_all ((omp_pause_resource_t) 0) == 0)
+    abort ();
+
+  /* GOMP_prewarm starts the threads ahead of the next region.  */
+  if (GOMP_prewarm (3) != 0 || num_threads (3) != 3)
+    abort ();
+  if (omp_pause_resource_all (omp_pause_hard) != 0 || num_threads (1) != 1)
+    abort ();
+  if (GOMP_prewarm (0) != 0 || num_threads (4) != 4)
+    abort ();
+  if (region () != 4 || num_threads (4) != 4)
+    abort ();
+
+  /* The mapping of a loop with a workload is computed again.  */
+  omp_set_workload (omp_loop_register ("pause"), workload, 8, false);
+  omp_set_schedule (omp_sched_binlpt, 0);
+  if (binlpt_loop () != 20)
+    abort ();
+  if (omp_pause_resource (omp_pause_soft, host) != 0 || binlpt_loop () != 20)
+    abort ();
+  if (omp_pause_resource (omp_pause_hard, host) != 0 || binlpt_loop () != 20)
+    abort ();
+
+  /* Neither can be used in a parallel region.  */
+  #pragma omp parallel num_threads (2) reduction (|:ret)
+  ret = (omp_pause_resource (omp_pause_soft, host) == 0
+	 || GOMP_prewarm (2) == 0);
+  if (ret)
+    abort ();
+  return 0;
+}
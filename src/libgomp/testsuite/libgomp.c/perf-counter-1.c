@@ -0,0 +1,101 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+
+/* GOMP_get_perf_counter counts up for the counters that are available,
+   which depends on the machine, and the counters of the threads are
+   closed when they exit, whoever started them.  */
+
+#include <omp.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Return the number of open file descriptors, waiting up to a second
+   for it to become EXPECTED.  */
+
+static int
+num_fds (int expected)
+{
+  int i, n = 0;
+
+  for (i = 0; i < 100; i++)
+    {
+      DIR *dir = opendir ("/proc/self/fd");
+      struct dirent *ent;
+
+      if (dir == NULL)
+	exit (0);
+      n = 0;
+      while ((ent = readdir (dir)) != NULL)
+	n += ent->d_name[0] != '.';
+      closedir (dir);
+      /* Without the one of DIR.  */
+      if (--n == expected)
+	break;
+      usleep (10000);
+    }
+  return n;
+}
+
+static void
+check (void)
+{
+  unsigned long long before, after;
+  volatile unsigned long spin;
+  int c;
+
+  for (c = gomp_perf_cycles; c <= gomp_perf_context_switches; c++)
+    if (GOMP_get_perf_counter (c, &before) == 0)
+      {
+	for (spin = 0; spin < 100000; spin++)
+	  ;
+	if (GOMP_get_perf_counter (c, &after) != 0 || after < before)
+	  abort ();
+	if ((c == gomp_perf_task_clock || c == gomp_perf_instructions)
+	    && after == before)
+	  abort ();
+      }
+}
+
+static void *
+thread_check (void *arg)
+{
+  (void) arg;
+  check ();
+  return NULL;
+}
+
+int
+main (void)
+{
+  pthread_t thread;
+  unsigned long long value = 42;
+  int fds, i;
+
+  if (GOMP_get_perf_counter (0, &value) != -1
+      || GOMP_get_perf_counter (gomp_perf_context_switches + 1, &value) != -1
+      || value != 42)
+    abort ();
+
+  /* The master keeps its counters open.  */
+  check ();
+  fds = num_fds (-1);
+
+  for (i = 0; i < 10; i++)
+    {
+      #pragma omp parallel num_threads (i % 4 + 1)
+      check ();
+      if (omp_pause_resource_all (omp_pause_hard) != 0
+	  || num_fds (fds) != fds)
+	abort ();
+    }
+
+  /* So are those of threads the runtime did not start.  */
+  for (i = 0; i < 10; i++)
+    if (pthread_create (&thread, NULL, thread_check, NULL) != 0
+	|| pthread_join (thread, NULL) != 0
+	|| num_fds (fds) != fds)
+      abort ();
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "4" } */
+/* { dg-set-target-env-var GOMP_PRESPAWN "3" } */
+
+/* With GOMP_PRESPAWN, the threads are started in the background once
+   the library is loaded, and the first team uses them.  */
+
+#include <omp.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Return the number of threads of the process, waiting up to a second
+   for it to become EXPECTED.  */
+
+static int
+num_threads (int expected)
+{
+  int i, n = 0;
+
+  for (i = 0; i < 100; i++)
+    {
+      DIR *dir = opendir ("/proc/self/task");
+      struct dirent *ent;
+
+      if (dir == NULL)
+	exit (0);
+      n = 0;
+      while ((ent = readdir (dir)) != NULL)
+	n += ent->d_name[0] != '.';
+      closedir (dir);
+      if (n == expected)
+	break;
+      usleep (10000);
+    }
+  return n;
+}
+
+static void *
+query (void *arg)
+{
+  (void) arg;
+  if (omp_get_max_threads () != 4)
+    abort ();
+  return NULL;
+}
+
+int
+main (void)
+{
+  const char *env = getenv ("GOMP_PRESPAWN");
+  int n = 0, status;
+  pthread_t thread;
+  pid_t pid;
+
+  if (env != NULL && strcmp (env, "true") == 0)
+    {
+      /* The pool of a team of OMP_NUM_THREADS threads.  */
+      if (num_threads (4) != 4)
+	abort ();
+      return 0;
+    }
+
+  /* The master and 2 more threads, without using the runtime.  */
+  if (num_threads (3) != 3)
+    abort ();
+
+  /* Another thread using the runtime starts no more.  */
+  if (pthread_create (&thread, NULL, query, NULL) != 0
+      || pthread_join (thread, NULL) != 0)
+    abort ();
+  if (num_threads (3) != 3)
+    abort ();
+
+  /* The first team uses them and starts the missing thread.  */
+  #pragma omp parallel reduction (+:n)
+  n++;
+  if (n != 4 || num_threads (4) != 4)
+    abort ();
+
+  if (setenv ("GOMP_PRESPAWN", "true", 1) < 0)
+    return 0;
+  pid = fork ();
+  if (pid == -1)
+    return 0;
+  if (pid == 0)
+    {
+      execl ("/proc/self/exe", "prespawn-1.exe", NULL);
+      _exit (0);
+    }
+  if (waitpid (pid, &status, 0) < 0)
+    return 0;
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,151 @@
+/* { dg-do run { target *-*-linux* } } */
+
+/* GOMP_PROFILE writes the summary of a run to the standard error or to
+   a file, with the performance counters with GOMP_PROFILE_COUNTERS.  */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+char buf[16384];
+
+static void
+work (int *p)
+{
+  usleep (1000);
+  #pragma omp atomic
+  *p += 1;
+}
+
+static int
+child (void)
+{
+  int i, n = 0;
+
+  #pragma omp parallel num_threads (2)
+  {
+    #pragma omp for ordered schedule (dynamic, 1)
+    for (i = 0; i < 8; i++)
+      #pragma omp ordered
+      work (&n);
+    #pragma omp single
+    for (i = 0; i < 4; i++)
+      #pragma omp task
+      work (&n);
+    #pragma omp barrier
+    #pragma omp critical
+    work (&n);
+  }
+  return n != 14;
+}
+
+/* Run the child with GOMP_PROFILE set to PROFILE and
+   GOMP_PROFILE_COUNTERS to COUNTERS, unless NULL, and read its standard
+   error into BUF.  Return its process ID.  */
+
+static pid_t
+run (const char *profile, const char *counters)
+{
+  int fds[2], status;
+  ssize_t len, size = 0;
+  pid_t pid;
+
+  if (pipe (fds) < 0)
+    exit (0);
+  pid = fork ();
+  if (pid == -1)
+    exit (0);
+  if (pid == 0)
+    {
+      close (fds[0]);
+      dup2 (fds[1], 2);
+      setenv ("GOMP_PROFILE", profile, 1);
+      if (counters != NULL)
+	setenv ("GOMP_PROFILE_COUNTERS", counters, 1);
+      execl ("/proc/self/exe", "profile-1.exe", "child", NULL);
+      _exit (0);
+    }
+  close (fds[1]);
+  while (size < (ssize_t) sizeof (buf) - 1
+	 && (len = read (fds[0], buf + size, sizeof (buf) - 1 - size)) > 0)
+    size += len;
+  buf[size] = '\0';
+  close (fds[0]);
+  if (waitpid (pid, &status, 0) < 0)
+    exit (0);
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    abort ();
+  return pid;
+}
+
+/* Check that BUF has the summary of the child PID.  */
+
+static void
+check (pid_t pid)
+{
+  char header[64];
+
+  sprintf (header, "libgomp profile of process %lu, 2 threads\n",
+	   (unsigned long) pid);
+  if (strncmp (buf, header, strlen (header)) != 0
+      || strstr (buf, "\nParallel regions:\n") == NULL
+      || strstr (buf, "\nBarrier waits:\n") == NULL
+      || strstr (buf, "  end of  ") == NULL
+      || strstr (buf, "\nLock waits:\n") == NULL
+      || strstr (buf, "  critical  ") == NULL
+      || strstr (buf, "  ordered  ") == NULL
+      || strstr (buf, "\nTasks:\n") == NULL
+      || strstr (buf, "\nLoops and sections:\n") == NULL
+      || strstr (buf, "  dynamic,1  ") == NULL)
+    abort ();
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *tmpdir = getenv ("TMPDIR");
+  unsigned long long value;
+  char name[4096], *p;
+  int counters;
+  FILE *f;
+  pid_t pid;
+
+  if (argc > 1 && strcmp (argv[1], "child") == 0)
+    return child ();
+
+  /* To the standard error.  */
+  pid = run ("true", NULL);
+  check (pid);
+  if (strstr (buf, "\nPerformance counters:\n") != NULL)
+    abort ();
+
+  /* Nothing.  */
+  run ("false", "true");
+  if (buf[0] != '\0')
+    abort ();
+
+  /* To a file, with the counters if the kernel lets the thread count
+     the time it ran.  */
+  counters = GOMP_get_perf_counter (gomp_perf_task_clock, &value) == 0;
+  if (tmpdir == NULL || strlen (tmpdir) > sizeof (name) - 64)
+    tmpdir = "/tmp";
+  sprintf (name, "%s/profile-1.%%p.txt", tmpdir);
+  pid = run (name, "true");
+  if (buf[0] != '\0')
+    abort ();
+  p = strstr (name, "%p");
+  sprintf (p, "%lu.txt", (unsigned long) pid);
+  f = fopen (name, "r");
+  if (f == NULL)
+    abort ();
+  buf[fread (buf, 1, sizeof (buf) - 1, f)] = '\0';
+  fclose (f);
+  unlink (name);
+  check (pid);
+  if ((strstr (buf, "\nPerformance counters:\n") != NULL) != counters)
+    abort ();
+  return 0;
+}
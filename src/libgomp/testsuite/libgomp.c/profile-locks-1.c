@@ -0,0 +1,135 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-additional-options "-rdynamic" } */
+
+/* GOMP_PROFILE_LOCKS adds to the profile the acquisitions, contention
+   and waits of each lock and critical construct, sorted by total
+   wait.  */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define N 8
+
+char buf[16384];
+omp_lock_t lock;
+
+static int
+child (void)
+{
+  int n = 0, k;
+
+  for (k = 0; k < 2; k++)
+    {
+      /* Statistics of the lock initialized again are merged.  */
+      omp_init_lock (&lock);
+      #pragma omp parallel num_threads (2) reduction (+:n)
+      {
+	int i;
+
+	for (i = 0; i < N / 2; i++)
+	  {
+	    #pragma omp critical (hot)
+	    {
+	      usleep (1000);
+	      n++;
+	    }
+	    #pragma omp critical
+	    n++;
+	    omp_set_lock (&lock);
+	    n++;
+	    omp_unset_lock (&lock);
+	  }
+      }
+      omp_destroy_lock (&lock);
+    }
+  return n != 3 * 2 * N;
+}
+
+/* Run the child with GOMP_PROFILE set to TRUE and GOMP_PROFILE_LOCKS to
+   LOCKS, and read its standard error into BUF.  */
+
+static void
+run (const char *locks)
+{
+  int fds[2], status;
+  ssize_t len, size = 0;
+  pid_t pid;
+
+  if (pipe (fds) < 0)
+    exit (0);
+  pid = fork ();
+  if (pid == -1)
+    exit (0);
+  if (pid == 0)
+    {
+      close (fds[0]);
+      dup2 (fds[1], 2);
+      setenv ("GOMP_PROFILE", "true", 1);
+      setenv ("GOMP_PROFILE_LOCKS", locks, 1);
+      execl ("/proc/self/exe", "profile-locks-1.exe", "child", NULL);
+      _exit (0);
+    }
+  close (fds[1]);
+  while (size < (ssize_t) sizeof (buf) - 1
+	 && (len = read (fds[0], buf + size, sizeof (buf) - 1 - size)) > 0)
+    size += len;
+  buf[size] = '\0';
+  close (fds[0]);
+  if (waitpid (pid, &status, 0) < 0)
+    exit (0);
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    abort ();
+}
+
+/* Return the line of the lock table for NAME, checking it was acquired
+   2 * N times and that CONTENDED is at least MIN_CONTENDED.  */
+
+static const char *
+find (const char *table, const char *name, unsigned long min_contended)
+{
+  const char *line = strstr (table, name);
+  unsigned long acquired, contended;
+
+  if (line == NULL)
+    abort ();
+  while (line > table && line[-1] != '\n')
+    line--;
+  if (sscanf (line, "%lu %lu", &acquired, &contended) != 2
+      || acquired != 2 * N || contended < min_contended
+      || contended > acquired)
+    abort ();
+  return line;
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *table, *hot, *critical, *lock;
+
+  if (argc > 1 && strcmp (argv[1], "child") == 0)
+    return child ();
+
+  run ("false");
+  if (strstr (buf, "libgomp profile of process ") != buf
+      || strstr (buf, "\nLocks:\n") != NULL)
+    abort ();
+
+  run ("true");
+  table = strstr (buf, "\nLocks:\n    acquired  contended     total"
+			"       max\n");
+  if (table == NULL)
+    abort ();
+
+  /* The named critical construct is named, and while one thread sleeps
+     in it, the other one waits for it.  */
+  hot = find (table, "  critical hot first at ", 1);
+  critical = find (table, "  critical first at ", 0);
+  lock = find (table, "  lock 0x", 0);
+  if (hot > critical || hot > lock)
+    abort ();
+  return 0;
+}
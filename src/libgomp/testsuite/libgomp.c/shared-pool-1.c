@@ -0,0 +1,101 @@
+/* { dg-do run { target *-*-linux* } } */
+/* { dg-set-target-env-var GOMP_SHARED_POOL "4" } */
+/* { dg-set-target-env-var OMP_NUM_THREADS "8" } */
+/* { dg-set-target-env-var OMP_WAIT_POLICY "passive" } */
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+int stage, release, sizes[4];
+long workers[64];
+int nworkers;
+
+/* Remember the calling thread if it is a worker not seen yet.  */
+
+static void
+note_worker (void)
+{
+  long tid = syscall (SYS_gettid);
+  int i;
+
+  #pragma omp critical (workers)
+  {
+    for (i = 0; i < nworkers; i++)
+      if (workers[i] == tid)
+	break;
+    if (i == nworkers && nworkers < 64)
+      workers[nworkers++] = tid;
+  }
+}
+
+static void *
+client (void *arg)
+{
+  int i = (long) arg;
+
+  #pragma omp parallel num_threads (i ? 8 : 2)
+  {
+    if (omp_get_thread_num () == 0)
+      {
+	int r;
+	sizes[i] = omp_get_num_threads ();
+	#pragma omp atomic write
+	stage = i + 1;
+	do
+	  #pragma omp atomic read
+	  r = release;
+	while (!r);
+      }
+    else
+      note_worker ();
+  }
+  return NULL;
+}
+
+int
+main (void)
+{
+  pthread_t threads[4];
+  long i;
+  int n;
+
+  /* Alone, a team gets the whole pool.  */
+  #pragma omp parallel
+  {
+    #pragma omp master
+    n = omp_get_num_threads ();
+    if (omp_get_thread_num () != 0)
+      note_worker ();
+  }
+  if (n != 5)
+    abort ();
+
+  /* Concurrent teams each get at most their share of the pool, and no
+     more workers than are idle.  The first team asks for 1 worker, the
+     second gets half of the pool, the third a third of it, and the last
+     one none as the pool is exhausted.  */
+  for (i = 0; i < 4; i++)
+    {
+      int s;
+      if (pthread_create (&threads[i], NULL, client, (void *) i) != 0)
+	abort ();
+      do
+	#pragma omp atomic read
+	s = stage;
+      while (s != i + 1);
+    }
+  #pragma omp atomic write
+  release = 1;
+  for (i = 0; i < 4; i++)
+    pthread_join (threads[i], NULL);
+  if (sizes[0] != 2 || sizes[1] != 3 || sizes[2] != 2 || sizes[3] != 1)
+    abort ();
+
+  /* All the teams borrowed the same workers.  */
+  if (nworkers > 4)
+    abort ();
+  return 0;
+}
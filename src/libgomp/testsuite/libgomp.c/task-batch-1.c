@@ -0,0 +1,74 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+#define N 100
+
+struct arg
+{
+  int i;
+  long double x;
+};
+
+int hits[N];
+
+static void
+fn (void *data)
+{
+  struct arg *a = data;
+
+  if (((__UINTPTR_TYPE__) a & (__alignof__ (struct arg) - 1)) != 0
+      || a->x != a->i * 0.5L)
+    abort ();
+  #pragma omp atomic
+  hits[a->i]++;
+}
+
+int
+main (void)
+{
+  struct arg args[N];
+  int i;
+
+  for (i = 0; i < N; i++)
+    {
+      args[i].i = i;
+      args[i].x = i * 0.5L;
+    }
+
+  /* The tasks get private copies of their argument blocks and, in a
+     single thread team, don't run before the taskwait.  */
+  #pragma omp parallel num_threads (1)
+  {
+    GOMP_task_batch (fn, args, sizeof (struct arg),
+		     __alignof__ (struct arg), N);
+    GOMP_task_batch (fn, args, sizeof (struct arg),
+		     __alignof__ (struct arg), 0);
+    for (i = 0; i < N; i++)
+      {
+	if (hits[i])
+	  abort ();
+	args[i].i = -1;
+      }
+    #pragma omp taskwait
+  }
+
+  for (i = 0; i < N; i++)
+    {
+      if (hits[i] != 1)
+	abort ();
+      args[i].i = i;
+    }
+
+  #pragma omp parallel
+  #pragma omp single
+  #pragma omp taskgroup
+  GOMP_task_batch (fn, args, sizeof (struct arg),
+		   __alignof__ (struct arg), N);
+
+  for (i = 0; i < N; i++)
+    if (hits[i] != 2)
+      abort ();
+  return 0;
+}
@@ -0,0 +1,52 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+#define N 1000
+
+int hits[N];
+
+static void
+fn (void *data, long i)
+{
+  if (data != hits)
+    abort ();
+  #pragma omp atomic
+  hits[i]++;
+}
+
+static void
+outer (void *data, long i)
+{
+  GOMP_task_range (fn, data, i * 100, i * 100 + 100);
+}
+
+int
+main (void)
+{
+  int i;
+
+  #pragma omp parallel
+  #pragma omp single
+  {
+    GOMP_task_range (fn, hits, 10, N);
+    GOMP_task_range (fn, hits, 5, 5);
+    GOMP_task_range (fn, hits, 7, 3);
+    #pragma omp taskwait
+    for (i = 0; i < N; i++)
+      if (hits[i] != (i >= 10))
+	abort ();
+  }
+
+  /* Ranges created from tasks belong to the taskgroup too.  */
+  #pragma omp parallel
+  #pragma omp single
+  #pragma omp taskgroup
+  GOMP_task_range (outer, hits, 0, N / 100);
+
+  for (i = 0; i < N; i++)
+    if (hits[i] != 1 + (i >= 10))
+      abort ();
+  return 0;
+}
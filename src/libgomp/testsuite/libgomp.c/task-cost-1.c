@@ -0,0 +1,40 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+#define N 16
+
+int order[N + 2], n;
+
+int
+main (void)
+{
+  int i;
+
+  /* The tasks of a single thread team only run in the barrier, longest
+     first.  The cost hint only applies to the next task, tasks without
+     one run last in creation order.  */
+  #pragma omp parallel num_threads (1)
+  {
+    #pragma omp task
+    order[n++] = N;
+    for (i = 0; i < N; i++)
+      {
+	GOMP_set_task_cost ((i * 5) % N + 1);
+	#pragma omp task firstprivate (i)
+	order[n++] = (i * 5) % N;
+      }
+    #pragma omp task
+    order[n++] = N + 1;
+  }
+
+  if (n != N + 2)
+    abort ();
+  for (i = 0; i < N; i++)
+    if (order[i] != N - 1 - i)
+      abort ();
+  if (order[N] != N || order[N + 1] != N + 1)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,40 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_MAX_TASK_PRIORITY "1" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int order[6], n;
+
+int
+main (void)
+{
+  static const int expected[6] = { 4, 1, 5, 3, 0, 2 };
+
+  /* Taskwait runs the children with the highest priority first, and
+     among those the longest first.  */
+  #pragma omp parallel num_threads (1)
+  {
+    GOMP_set_task_cost (10);
+    #pragma omp task
+    order[n++] = 0;
+    GOMP_set_task_cost (20);
+    #pragma omp task priority (1)
+    order[n++] = 1;
+    #pragma omp task
+    order[n++] = 2;
+    GOMP_set_task_cost (30);
+    #pragma omp task
+    order[n++] = 3;
+    GOMP_set_task_cost (30);
+    #pragma omp task priority (1)
+    order[n++] = 4;
+    #pragma omp task priority (1)
+    order[n++] = 5;
+    #pragma omp taskwait
+    for (n = 0; n < 6; n++)
+      if (order[n] != expected[n])
+	abort ();
+  }
+  return 0;
+}
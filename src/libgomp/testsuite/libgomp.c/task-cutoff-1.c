@@ -0,0 +1,28 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var GOMP_TASK_CUTOFF "adaptive,1,2" } */
+
+#include <stdlib.h>
+
+int ran[5];
+
+int
+main (void)
+{
+  int i;
+
+  /* Tasks of the implicit task are 1 deep, so once the thread has 2
+     tasks of its own queued, the next ones run undeferred.  */
+  #pragma omp parallel num_threads (1)
+  for (i = 0; i < 5; i++)
+    {
+      #pragma omp task firstprivate (i)
+      ran[i] = 1;
+      if (ran[i] != (i >= 2))
+	abort ();
+    }
+
+  for (i = 0; i < 5; i++)
+    if (!ran[i])
+      abort ();
+  return 0;
+}
@@ -0,0 +1,30 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var GOMP_TASK_CUTOFF "fixed" } */
+
+#include <stdlib.h>
+
+#define N 80
+
+int ran[N];
+
+int
+main (void)
+{
+  int i;
+
+  /* The team only runs tasks undeferred once it has more than 64 per
+     thread.  */
+  #pragma omp parallel num_threads (1)
+  for (i = 0; i < N; i++)
+    {
+      #pragma omp task firstprivate (i)
+      ran[i] = 1;
+      if (ran[i] != (i > 64))
+	abort ();
+    }
+
+  for (i = 0; i < N; i++)
+    if (!ran[i])
+      abort ();
+  return 0;
+}
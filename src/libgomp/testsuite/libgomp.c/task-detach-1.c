@@ -0,0 +1,74 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int x, y, ran[5], fulfilled[3], published;
+
+int
+main (void)
+{
+  /* A detached task only completes, releasing its dependent tasks and
+     taskwait, once its event has been fulfilled.  */
+  #pragma omp parallel num_threads (2)
+  #pragma omp single
+  {
+    omp_event_handle_t ev, h;
+    #pragma omp task depend (out: x) detach (ev)
+    ran[0] = 1;
+    #pragma omp task depend (in: x)
+    {
+      if (!ran[0] || !fulfilled[0])
+	abort ();
+      ran[1] = 1;
+    }
+    #pragma omp task
+    {
+      fulfilled[0] = 1;
+      omp_fulfill_event (ev);
+    }
+    #pragma omp taskwait
+    if (!ran[1])
+      abort ();
+
+    #pragma omp task depend (out: y) shared (h)
+    {
+      h = GOMP_task_detach ();
+      if (GOMP_task_detach () != h)
+	abort ();
+      ran[2] = 1;
+      #pragma omp atomic write
+      published = 1;
+    }
+    #pragma omp task depend (in: y)
+    {
+      if (!ran[2] || !fulfilled[1])
+	abort ();
+      ran[3] = 1;
+    }
+    #pragma omp task shared (h)
+    {
+      int p;
+      do
+	#pragma omp atomic read
+	p = published;
+      while (!p);
+      fulfilled[1] = 1;
+      omp_fulfill_event (h);
+    }
+    #pragma omp taskwait
+    if (!ran[3])
+      abort ();
+
+    /* An undeferred task may fulfill its own event.  */
+    #pragma omp task detach (ev) if (0)
+    {
+      ran[4] = 1;
+      fulfilled[2] = 1;
+      omp_fulfill_event (ev);
+    }
+    if (!ran[4] || !fulfilled[2])
+      abort ();
+  }
+  return 0;
+}
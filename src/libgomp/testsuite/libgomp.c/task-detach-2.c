@@ -0,0 +1,47 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var GOMP_TASK_CUTOFF "adaptive,1,0" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+omp_event_handle_t *ev;
+int published, ran, fulfilled;
+
+int
+main (void)
+{
+  /* The cutoff would run every task undeferred, but a detached one is
+     still deferred, and its event gets fulfilled by another thread.  */
+  #pragma omp parallel num_threads (2)
+  {
+    if (omp_get_thread_num () == 0)
+      {
+	omp_event_handle_t e;
+	#pragma omp task detach (e)
+	ran = 1;
+	if (ran)
+	  abort ();
+	ev = &e;
+	#pragma omp atomic write
+	published = 1;
+	#pragma omp taskwait
+	int f;
+	#pragma omp atomic read
+	f = fulfilled;
+	if (!ran || !f)
+	  abort ();
+      }
+    else
+      {
+	int p;
+	do
+	  #pragma omp atomic read
+	  p = published;
+	while (!p);
+	#pragma omp atomic write
+	fulfilled = 1;
+	omp_fulfill_event (*ev);
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,50 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_PROC_BIND "true" } */
+/* { dg-set-target-env-var OMP_PLACES "{0},{0},{0}" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int order[7], n;
+
+int
+main (void)
+{
+  static const int expected[7] = { 3, 1, 4, 5, 6, 0, 2 };
+  int i;
+
+  /* The tasks of a single thread team bound to the first place only run
+     in the barrier.  Those meant for its place run first, then those of
+     the shared queue, and only then are tasks of other places stolen.
+     All the places are on the same NUMA node, so address hints are
+     ignored.  */
+  #pragma omp parallel num_threads (1)
+  {
+    GOMP_set_task_place (1);
+    #pragma omp task
+    order[n++] = 0;
+    #pragma omp task
+    order[n++] = 1;
+    GOMP_set_task_place (2);
+    #pragma omp task
+    order[n++] = 2;
+    GOMP_set_task_place (0);
+    #pragma omp task
+    order[n++] = 3;
+    GOMP_set_task_place (3);
+    #pragma omp task
+    order[n++] = 4;
+    GOMP_set_task_place (2);
+    GOMP_set_task_place (-1);
+    #pragma omp task
+    order[n++] = 5;
+    GOMP_set_task_affinity (order);
+    #pragma omp task
+    order[n++] = 6;
+  }
+
+  for (i = 0; i < 7; i++)
+    if (order[i] != expected[i])
+      abort ();
+  return 0;
+}
@@ -0,0 +1,35 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_PROC_BIND "false" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int order[4], n;
+
+int
+main (void)
+{
+  int i;
+
+  /* Without threads bound to places, the hints are ignored and the tasks
+     run in creation order.  */
+  #pragma omp parallel num_threads (1)
+  {
+    GOMP_set_task_place (1);
+    #pragma omp task
+    order[n++] = 0;
+    GOMP_set_task_affinity (order);
+    #pragma omp task
+    order[n++] = 1;
+    GOMP_set_task_place (0);
+    #pragma omp task
+    order[n++] = 2;
+    #pragma omp task
+    order[n++] = 3;
+  }
+
+  for (i = 0; i < 4; i++)
+    if (order[i] != i)
+      abort ();
+  return 0;
+}
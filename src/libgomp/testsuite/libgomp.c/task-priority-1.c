@@ -0,0 +1,35 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_MAX_TASK_PRIORITY "10" } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+int order[12], n;
+
+int
+main (void)
+{
+  static const int prio[12] = { 3, 0, 7, 50, 1, 9, 4, 10, 2, 8, 6, 5 };
+  static const int expected[12] = { 3, 7, 5, 9, 2, 10, 11, 6, 0, 8, 4, 1 };
+  int i;
+
+  if (omp_get_max_task_priority () != 10)
+    abort ();
+
+  /* The tasks of a single thread team only run in the barrier, highest
+     priority first.  Priorities above the maximum are clamped to it, and
+     tasks of equal priority run in creation order.  */
+  #pragma omp parallel num_threads (1)
+  for (i = 0; i < 12; i++)
+    {
+      #pragma omp task firstprivate (i) priority (prio[i])
+      order[n++] = i;
+    }
+
+  if (n != 12)
+    abort ();
+  for (i = 0; i < 12; i++)
+    if (order[i] != expected[i])
+      abort ();
+  return 0;
+}
@@ -0,0 +1,33 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var OMP_MAX_TASK_PRIORITY "1000" } */
+
+#include <stdlib.h>
+
+#define N 24
+
+int order[N], n;
+
+int
+main (void)
+{
+  int i;
+
+  /* With more priorities than ready queue buckets, tasks sharing a
+     bucket still run highest priority first in taskwait.  */
+  #pragma omp parallel num_threads (1)
+  {
+    for (i = 0; i < N; i++)
+      {
+	#pragma omp task firstprivate (i) priority ((i * 7) % N * 40)
+	order[n++] = (i * 7) % N;
+      }
+    #pragma omp taskwait
+    if (n != N)
+      abort ();
+  }
+
+  for (i = 0; i < N; i++)
+    if (order[i] != N - 1 - i)
+      abort ();
+  return 0;
+}
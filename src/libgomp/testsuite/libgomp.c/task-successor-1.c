@@ -0,0 +1,41 @@
+/* { dg-do run } */
+
+#include <stdlib.h>
+
+int order, a, b, c[5];
+
+int
+main (void)
+{
+  int x = 0, i;
+
+  /* With a single thread, the queued tasks run in the implicit barrier
+     in the order they were created, except that a task released by the
+     one that just finished runs right away.  */
+  #pragma omp parallel num_threads (1)
+  {
+    #pragma omp task shared (x) depend(out: x)
+    {
+      x = 1;
+      a = ++order;
+    }
+    for (i = 0; i < 5; i++)
+      {
+	#pragma omp task firstprivate (i)
+	c[i] = ++order;
+      }
+    #pragma omp task shared (x) depend(in: x)
+    {
+      if (x != 1)
+	abort ();
+      b = ++order;
+    }
+  }
+
+  if (a != 1 || b != 2)
+    abort ();
+  for (i = 0; i < 5; i++)
+    if (c[i] != i + 3)
+      abort ();
+  return 0;
+}
@@ -0,0 +1,41 @@
+/* { dg-do run } */
+/* { dg-set-target-env-var GOMP_TASK_SUCCESSOR_DEPTH "0" } */
+
+#include <stdlib.h>
+
+int order, a, b, c[5];
+
+int
+main (void)
+{
+  int x = 0, i;
+
+  /* Without immediate successors, the released task is queued behind
+     the tasks created before it.  */
+  #pragma omp parallel num_threads (1)
+  {
+    #pragma omp task shared (x) depend(out: x)
+    {
+      x = 1;
+      a = ++order;
+    }
+    for (i = 0; i < 5; i++)
+      {
+	#pragma omp task firstprivate (i)
+	c[i] = ++order;
+      }
+    #pragma omp task shared (x) depend(in: x)
+    {
+      if (x != 1)
+	abort ();
+      b = ++order;
+    }
+  }
+
+  if (a != 1 || b != 7)
+    abort ();
+  for (i = 0; i < 5; i++)
+    if (c[i] != i + 2)
+      abort ();
+  return 0;
+}
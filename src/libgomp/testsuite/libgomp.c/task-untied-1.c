@@ -0,0 +1,43 @@
+/* { dg-do run { target x86_64-*-linux* aarch64*-*-linux* } } */
+
+#include <stdlib.h>
+
+int started, done;
+
+int
+main (void)
+{
+  /* The untied task waits for a child which only finishes once a task
+     queued in the team has run.  The only thread that can run it is the
+     one of the untied task, which has to suspend it in the taskwait.  */
+  #pragma omp parallel num_threads (2)
+  #pragma omp single
+  #pragma omp task untied
+  {
+    #pragma omp task
+    {
+      #pragma omp task
+      {
+	#pragma omp atomic write
+	done = 1;
+      }
+      #pragma omp atomic write
+      started = 1;
+      int d;
+      do
+	#pragma omp atomic read
+	d = done;
+      while (!d);
+    }
+    int s;
+    do
+      #pragma omp atomic read
+      s = started;
+    while (!s);
+    #pragma omp taskwait
+  }
+
+  if (!done)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,48 @@
+/* { dg-do run { target x86_64-*-linux* aarch64*-*-linux* } } */
+/* { dg-set-target-env-var GOMP_TASK_STACKSIZE "4M" } */
+
+#include <stdlib.h>
+#include <string.h>
+
+static long
+fib (int n)
+{
+  long a, b;
+
+  if (n < 2)
+    return n;
+  #pragma omp task untied shared (a)
+  a = fib (n - 1);
+  #pragma omp task untied shared (b)
+  b = fib (n - 2);
+  #pragma omp taskwait
+  return a + b;
+}
+
+static void
+use_stack (void)
+{
+  char buf[2 << 20];
+
+  memset (buf, 1, sizeof (buf));
+  __asm__ volatile ("" : : "r" (buf) : "memory");
+}
+
+int
+main (void)
+{
+  long r;
+
+  #pragma omp parallel
+  #pragma omp single
+  {
+    r = fib (20);
+    /* Untied tasks run on stacks of GOMP_TASK_STACKSIZE bytes.  */
+    #pragma omp task untied
+    use_stack ();
+  }
+
+  if (r != 6765)
+    abort ();
+  return 0;
+}
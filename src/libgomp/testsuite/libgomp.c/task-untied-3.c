@@ -0,0 +1,36 @@
+/* { dg-do run { target x86_64-*-linux* aarch64*-*-linux* } } */
+/* { dg-set-target-env-var OMP_STACKSIZE "8M" } */
+
+#include <stdlib.h>
+
+/* Without GOMP_TASK_STACKSIZE, untied tasks get stacks as large as
+   those of the threads.  */
+
+static int
+recurse (int n)
+{
+  volatile int buf[256];
+
+  buf[0] = n;
+  if (n == 0)
+    return buf[0];
+  return recurse (n - 1) + buf[0] - n;
+}
+
+int
+main (void)
+{
+  int r = -1;
+
+  #pragma omp parallel
+  #pragma omp single
+  {
+    #pragma omp task untied shared (r)
+    r = recurse (4096);
+    #pragma omp taskwait
+  }
+
+  if (r != 0)
+    abort ();
+  return 0;
+}
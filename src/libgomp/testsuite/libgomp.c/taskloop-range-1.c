@@ -0,0 +1,66 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+#define N 100
+
+int hits[N], nchunks, minsize;
+
+static void
+fn (void *data, long lo, long hi)
+{
+  long i;
+
+  if (data != hits || lo < 0 || hi > N || lo >= hi)
+    abort ();
+  for (i = lo; i < hi; i++)
+    {
+      #pragma omp atomic
+      hits[i]++;
+    }
+  #pragma omp critical
+  {
+    nchunks++;
+    if (hi - lo < minsize)
+      minsize = hi - lo;
+  }
+}
+
+static void
+check (long start, long grainsize, long num_tasks, int expected)
+{
+  int i;
+
+  nchunks = 0;
+  minsize = N;
+  GOMP_taskloop_range (fn, hits, start, N, grainsize, num_tasks, false);
+  /* All the chunks have run by the time the call returns, and have at
+     least GRAINSIZE iterations unless there are fewer in total.  */
+  if (nchunks != expected)
+    abort ();
+  if (nchunks > 1 && minsize < grainsize)
+    abort ();
+  for (i = 0; i < N; i++)
+    if (hits[i] != (i >= start))
+      abort ();
+    else
+      hits[i] = 0;
+}
+
+int
+main (void)
+{
+  #pragma omp parallel num_threads (4)
+  #pragma omp single
+  {
+    check (0, 7, 0, 14);
+    check (0, 200, 0, 1);
+    check (0, 0, 5, 5);
+    check (90, 0, 50, 10);
+    check (0, 0, 0, omp_get_num_threads ());
+    check (N, 1, 0, 0);
+  }
+  check (0, 0, 0, 1);
+  return 0;
+}
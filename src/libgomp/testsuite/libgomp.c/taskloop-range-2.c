@@ -0,0 +1,63 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <stdlib.h>
+
+long chunks[2][2];
+int nchunks;
+
+static void
+fn (void *data, long lo, long hi)
+{
+  int n;
+
+  #pragma omp atomic capture
+  n = nchunks++;
+  if (n >= 2)
+    abort ();
+  chunks[n][0] = lo;
+  chunks[n][1] = hi;
+}
+
+static void
+check (long lo, long hi)
+{
+  if ((chunks[0][0] != lo || chunks[0][1] != hi)
+      && (chunks[1][0] != lo || chunks[1][1] != hi))
+    abort ();
+}
+
+int
+main (void)
+{
+  static unsigned workload[8] = { 10, 1, 1, 1, 1, 1, 1, 4 };
+
+  /* Weighted chunks have about the same total workload.  */
+  omp_set_workload (0, workload, 8, true);
+  #pragma omp parallel
+  #pragma omp single
+  {
+    GOMP_taskloop_range (fn, NULL, 0, 8, 0, 2, true);
+    if (nchunks != 2)
+      abort ();
+    check (0, 2);
+    check (2, 8);
+
+    /* Without WEIGHTED, or if the workload doesn't describe the range,
+       the chunks have the same number of iterations.  */
+    nchunks = 0;
+    GOMP_taskloop_range (fn, NULL, 0, 8, 0, 2, false);
+    if (nchunks != 2)
+      abort ();
+    check (0, 4);
+    check (4, 8);
+
+    nchunks = 0;
+    GOMP_taskloop_range (fn, NULL, 0, 10, 0, 2, true);
+    if (nchunks != 2)
+      abort ();
+    check (0, 5);
+    check (5, 10);
+  }
+  return 0;
+}
@@ -0,0 +1,268 @@
+/* { dg-do run } */
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+struct record
+{
+  gomp_tool_event_t event;
+  const void *object;
+  unsigned long arg0, arg1;
+} records[1024];
+int nrecords;
+pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+callback (gomp_tool_event_t event, const void *object, unsigned long arg0,
+	  unsigned long arg1)
+{
+  pthread_mutex_lock (&records_lock);
+  if (nrecords == 1024)
+    abort ();
+  records[nrecords].event = event;
+  records[nrecords].object = object;
+  records[nrecords].arg0 = arg0;
+  records[nrecords].arg1 = arg1;
+  nrecords++;
+  pthread_mutex_unlock (&records_lock);
+}
+
+/* Return the number of records of EVENT, and check that they all have
+   the arguments ARG0 and ARG1 that are not -1.  */
+
+static int
+count (gomp_tool_event_t event, long arg0, long arg1)
+{
+  int i, n = 0;
+
+  for (i = 0; i < nrecords; i++)
+    if (records[i].event == event)
+      {
+	if ((arg0 != -1 && records[i].arg0 != (unsigned long) arg0)
+	    || (arg1 != -1 && records[i].arg1 != (unsigned long) arg1))
+	  abort ();
+	n++;
+      }
+  return n;
+}
+
+/* Wait for the NTHREADS threads of the last parallel region to report
+   the end of their implicit tasks, which they do after its master left
+   it.  */
+
+static void
+settle (int nthreads)
+{
+  int n;
+
+  do
+    {
+      pthread_mutex_lock (&records_lock);
+      n = count (gomp_tool_event_implicit_task_end, -1, 0);
+      pthread_mutex_unlock (&records_lock);
+    }
+  while (n < nthreads);
+}
+
+static void
+task (int *p)
+{
+  #pragma omp atomic
+  *p += 1;
+}
+
+int
+main (void)
+{
+  int i, n, mask, sum;
+  omp_lock_t lock;
+  omp_nest_lock_t nest_lock;
+
+  if (GOMP_tool_set_callback (0, callback) != -1
+      || GOMP_tool_set_callback (gomp_tool_event_lock_release + 1,
+				 callback) != -1)
+    abort ();
+  for (i = gomp_tool_event_parallel_begin;
+       i <= gomp_tool_event_lock_release; i++)
+    if (GOMP_tool_set_callback (i, callback) != 0)
+      abort ();
+
+  /* A parallel region, its implicit tasks and its final barrier.  */
+  #pragma omp parallel num_threads (3)
+  if (omp_get_num_threads () != 3)
+    abort ();
+  settle (3);
+  mask = 0;
+  for (i = 0; i < nrecords; i++)
+    if (records[i].event == gomp_tool_event_implicit_task_begin)
+      mask |= 1 << records[i].arg0;
+  if (count (gomp_tool_event_parallel_begin, 3, -1) != 1
+      || count (gomp_tool_event_parallel_end, 3, 0) != 1
+      || count (gomp_tool_event_implicit_task_begin, -1, -1) != 3
+      || count (gomp_tool_event_implicit_task_end, -1, 0) != 3
+      || mask != 7
+      || count (gomp_tool_event_barrier_wait_begin, 0, 0)
+	 != count (gomp_tool_event_barrier_wait_end, 0, 0))
+    abort ();
+
+  /* Loops, with the chunks each thread is handed.  */
+  nrecords = 0;
+  #pragma omp parallel num_threads (2)
+  {
+    #pragma omp for ordered schedule (dynamic, 2)
+    for (i = 0; i < 10; i++)
+      ;
+  }
+  settle (2);
+  if (count (gomp_tool_event_work_begin, omp_sched_dynamic, 2) != 2
+      || count (gomp_tool_event_work_end, -1, 0) != 2)
+    abort ();
+  n = sum = 0;
+  for (i = 0; i < nrecords; i++)
+    if (records[i].event == gomp_tool_event_work_chunk)
+      {
+	if (records[i].arg1 - records[i].arg0 != 2)
+	  abort ();
+	sum += records[i].arg1 - records[i].arg0;
+	n++;
+      }
+  if (n != 5 || sum != 10)
+    abort ();
+
+  nrecords = 0;
+  #pragma omp parallel num_threads (2)
+  {
+    #pragma omp for ordered schedule (static, 1)
+    for (i = 0; i < 10; i++)
+      #pragma omp ordered
+      ;
+  }
+  settle (2);
+  if (count (gomp_tool_event_work_begin, omp_sched_static, 1) != 2
+      || count (gomp_tool_event_work_end, -1, 0) != 2
+      || count (gomp_tool_event_work_chunk, -1, -1) != 10
+      || count (gomp_tool_event_barrier_wait_begin, -1, 0) < 2)
+    abort ();
+  for (i = 0; i < nrecords; i++)
+    if (records[i].event == gomp_tool_event_work_end && records[i].arg0 == 0)
+      abort ();
+
+  /* Sections.  */
+  nrecords = 0;
+  #pragma omp parallel sections num_threads (2)
+  {
+    #pragma omp section
+    ;
+    #pragma omp section
+    ;
+    #pragma omp section
+    ;
+  }
+  settle (2);
+  if (count (gomp_tool_event_work_begin, 0, 3) != 2
+      || count (gomp_tool_event_work_chunk, -1, -1) != 3)
+    abort ();
+
+  /* Explicit tasks.  */
+  nrecords = 0;
+  n = 0;
+  #pragma omp parallel num_threads (2)
+  #pragma omp single
+  {
+    for (i = 0; i < 5; i++)
+      #pragma omp task
+      task (&n);
+    #pragma omp task if (0)
+    task (&n);
+  }
+  settle (2);
+  sum = 0;
+  for (i = 0; i < nrecords; i++)
+    if (records[i].event == gomp_tool_event_task_create)
+      sum += records[i].arg1;
+  if (n != 6
+      || count (gomp_tool_event_task_create, -1, -1) != 6
+      || sum != 5
+      || count (gomp_tool_event_task_complete, -1, 0) != 6
+      || count (gomp_tool_event_task_schedule, -1, 0) < 6)
+    abort ();
+
+  /* Locks and critical constructs.  A nested lock is only acquired and
+     released once.  */
+  nrecords = 0;
+  omp_init_lock (&lock);
+  omp_set_lock (&lock);
+  omp_unset_lock (&lock);
+  omp_destroy_lock (&lock);
+  if (count (gomp_tool_event_lock_wait_begin, gomp_tool_mutex_lock, -1) != 1
+      || count (gomp_tool_event_lock_wait_end, gomp_tool_mutex_lock, -1) != 1
+      || count (gomp_tool_event_lock_release, gomp_tool_mutex_lock, -1) != 1
+      || records[0].object != records[2].object)
+    abort ();
+
+  nrecords = 0;
+  omp_init_nest_lock (&nest_lock);
+  omp_set_nest_lock (&nest_lock);
+  omp_set_nest_lock (&nest_lock);
+  omp_unset_nest_lock (&nest_lock);
+  omp_unset_nest_lock (&nest_lock);
+  omp_destroy_nest_lock (&nest_lock);
+  if (count (gomp_tool_event_lock_wait_begin, gomp_tool_mutex_nest_lock,
+	     -1) != 1
+      || count (gomp_tool_event_lock_release, gomp_tool_mutex_nest_lock,
+		-1) != 1)
+    abort ();
+
+  /* The test routines report the locks they take as waits that found
+     them free.  */
+  nrecords = 0;
+  omp_init_lock (&lock);
+  if (!omp_test_lock (&lock) || omp_test_lock (&lock))
+    abort ();
+  omp_unset_lock (&lock);
+  omp_destroy_lock (&lock);
+  omp_init_nest_lock (&nest_lock);
+  if (omp_test_nest_lock (&nest_lock) != 1
+      || omp_test_nest_lock (&nest_lock) != 2)
+    abort ();
+  omp_unset_nest_lock (&nest_lock);
+  omp_unset_nest_lock (&nest_lock);
+  omp_destroy_nest_lock (&nest_lock);
+  if (nrecords != 6)
+    abort ();
+  for (i = 0; i < 6; i++)
+    if (records[i].event != (i % 3 == 0 ? gomp_tool_event_lock_wait_begin
+			     : i % 3 == 1 ? gomp_tool_event_lock_wait_end
+			     : gomp_tool_event_lock_release)
+	|| records[i].arg0 != (i < 3 ? gomp_tool_mutex_lock
+			       : gomp_tool_mutex_nest_lock))
+      abort ();
+
+  nrecords = 0;
+  #pragma omp critical
+  ;
+  #pragma omp critical (name)
+  ;
+  if (count (gomp_tool_event_lock_wait_begin, gomp_tool_mutex_critical,
+	     -1) != 2
+      || count (gomp_tool_event_lock_wait_end, gomp_tool_mutex_critical,
+		-1) != 2
+      || count (gomp_tool_event_lock_release, gomp_tool_mutex_critical,
+		-1) != 2
+      || records[0].object == records[3].object)
+    abort ();
+
+  /* Once the callbacks are removed, nothing is reported.  */
+  for (i = gomp_tool_event_parallel_begin;
+       i <= gomp_tool_event_lock_release; i++)
+    if (GOMP_tool_set_callback (i, NULL) != 0)
+      abort ();
+  nrecords = 0;
+  #pragma omp parallel num_threads (2)
+  #pragma omp critical
+  ;
+  if (nrecords != 0)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,52 @@
+/* { dg-do run { target *-*-linux* } } */
+
+/* The tools of GOMP_TOOL that can not be loaded are reported and
+   skipped.  */
+
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int
+main (void)
+{
+  char buf[1024];
+  int fds[2], status, n = 0;
+  ssize_t len, size = 0;
+  pid_t pid;
+
+  if (getenv ("GOMP_TOOL") != NULL)
+    {
+      #pragma omp parallel num_threads (2) reduction (+:n)
+      n++;
+      return n != 2;
+    }
+
+  if (setenv ("GOMP_TOOL", "libgomp-no-such-tool.so::libc.so.6", 1) < 0
+      || pipe (fds) < 0)
+    return 0;
+  pid = fork ();
+  if (pid == -1)
+    return 0;
+  if (pid == 0)
+    {
+      close (fds[0]);
+      dup2 (fds[1], 2);
+      execl ("/proc/self/exe", "tool-2.exe", NULL);
+      _exit (0);
+    }
+  close (fds[1]);
+  while (size < (ssize_t) sizeof (buf) - 1
+	 && (len = read (fds[0], buf + size, sizeof (buf) - 1 - size)) > 0)
+    size += len;
+  buf[size] = '\0';
+  if (waitpid (pid, &status, 0) < 0)
+    return 0;
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0
+      || strstr (buf, "Cannot load tool libgomp-no-such-tool.so") == NULL
+      || strstr (buf, "Tool libc.so.6 has no GOMP_tool_initialize") == NULL)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,194 @@
+/* { dg-do run { target *-*-linux* } } */
+
+/* GOMP_TRACE writes a timeline of the runtime events of each thread,
+   bounded by GOMP_TRACE_BUFFER and thinned by GOMP_TRACE_SAMPLING.  The
+   buffer of a thread that exited is reused by the next one.  */
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define N 100
+
+char name[4096];
+
+struct trace
+{
+  /* The number of events of each thread.  */
+  int events[3];
+  int chunks, iterations;
+  int parallel, implicit_tasks, loops, barriers, tasks, critical;
+};
+
+static void *
+thread_region (void *arg)
+{
+  int *n = (int *) arg;
+
+  #pragma omp parallel num_threads (1)
+  (*n)++;
+  return NULL;
+}
+
+static int
+child (void)
+{
+  pthread_t thread;
+  int i, n = 0;
+
+  #pragma omp parallel num_threads (2)
+  {
+    #pragma omp for ordered schedule (dynamic, 1)
+    for (i = 0; i < N; i++)
+      {
+	#pragma omp atomic
+	n++;
+      }
+    #pragma omp single
+    #pragma omp task
+    n++;
+    #pragma omp critical
+    n++;
+  }
+
+  /* Threads started one after the other share a buffer.  */
+  for (i = 0; i < 3; i++)
+    if (pthread_create (&thread, NULL, thread_region, &n) != 0
+	|| pthread_join (thread, NULL) != 0)
+      return 1;
+  return n != N + 6;
+}
+
+/* Run the child with GOMP_TRACE naming a file and the environment
+   variable VAR, unless NULL, set to VALUE, and read the trace it wrote
+   into T.  */
+
+static void
+run (const char *var, const char *value, struct trace *t)
+{
+  char line[512], *p;
+  int status, depth[3] = { 0, 0, 0 };
+  unsigned long start, end;
+  FILE *f;
+  pid_t pid;
+
+  pid = fork ();
+  if (pid == -1)
+    exit (0);
+  if (pid == 0)
+    {
+      setenv ("GOMP_TRACE", name, 1);
+      if (var != NULL)
+	setenv (var, value, 1);
+      execl ("/proc/self/exe", "trace-1.exe", "child", NULL);
+      _exit (0);
+    }
+  if (waitpid (pid, &status, 0) < 0)
+    exit (0);
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    abort ();
+
+  p = strstr (name, "%p");
+  sprintf (line, "%.*s%lu%s", (int) (p - name), name, (unsigned long) pid,
+	   p + 2);
+  f = fopen (line, "r");
+  if (f == NULL)
+    abort ();
+  unlink (line);
+  memset (t, 0, sizeof (*t));
+  if (fgets (line, sizeof (line), f) == NULL
+      || strcmp (line, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n") != 0)
+    abort ();
+  while (fgets (line, sizeof (line), f) != NULL
+	 && strcmp (line, "]}\n") != 0)
+    {
+      int tid;
+
+      if (strncmp (line, "{\"ph\":\"M\"", 9) == 0)
+	continue;
+      p = strstr (line, "\"tid\":");
+      if (p == NULL || sscanf (p, "\"tid\":%d", &tid) != 1
+	  || tid < 0 || tid > 2)
+	abort ();
+      t->events[tid]++;
+
+      /* Events begin and end in order.  */
+      if (strncmp (line, "{\"ph\":\"E\"", 9) == 0)
+	{
+	  if (--depth[tid] < 0)
+	    abort ();
+	  continue;
+	}
+      if (strncmp (line, "{\"ph\":\"B\"", 9) != 0)
+	abort ();
+      depth[tid]++;
+      if (strstr (line, "\"name\":\"chunk\"") != NULL)
+	{
+	  p = strstr (line, "\"start\":");
+	  if (p == NULL
+	      || sscanf (p, "\"start\":%lu,\"end\":%lu", &start, &end) != 2
+	      || start >= end || end > N)
+	    abort ();
+	  t->chunks++;
+	  t->iterations += end - start;
+	}
+      else if (strstr (line, "\"name\":\"parallel ") != NULL)
+	t->parallel++;
+      else if (strstr (line, "\"name\":\"implicit task ") != NULL)
+	t->implicit_tasks++;
+      else if (strstr (line, "\"name\":\"loop\"") != NULL)
+	t->loops++;
+      else if (strstr (line, "\"name\":\"barrier ") != NULL)
+	t->barriers++;
+      else if (strstr (line, "\"name\":\"task ") != NULL)
+	t->tasks++;
+      else if (strstr (line, "\"name\":\"critical wait\"") != NULL)
+	t->critical++;
+    }
+  /* The worker may not have ended its implicit task and the join yet
+     when the master wrote the trace at exit.  */
+  if (strcmp (line, "]}\n") != 0 || fgets (line, sizeof (line), f) != NULL
+      || depth[0] != 0 || depth[1] > 2 || depth[2] != 0)
+    abort ();
+  fclose (f);
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *tmpdir = getenv ("TMPDIR");
+  struct trace t;
+
+  if (argc > 1 && strcmp (argv[1], "child") == 0)
+    return child ();
+
+  if (tmpdir == NULL || strlen (tmpdir) > sizeof (name) - 64)
+    tmpdir = "/tmp";
+  sprintf (name, "%s/trace-1.%%p.json", tmpdir);
+
+  /* Everything.  */
+  run (NULL, NULL, &t);
+  if (t.chunks != N || t.iterations != N
+      || t.parallel != 4 || t.implicit_tasks != 5 || t.loops != 2
+      || t.barriers < 4 || t.tasks != 1 || t.critical != 2
+      || t.events[2] != 18)
+    abort ();
+
+  /* One in 10 chunks and ordered waits of each thread, of which there
+     are up to one per chunk.  */
+  run ("GOMP_TRACE_SAMPLING", "10", &t);
+  if (t.chunks < 1 || t.chunks > N / 5 + 2
+      || t.parallel != 4 || t.implicit_tasks != 5 || t.loops != 2
+      || t.tasks != 1 || t.critical != 2)
+    abort ();
+
+  /* The last 16 events of each thread.  */
+  run ("GOMP_TRACE_BUFFER", "16", &t);
+  if (t.events[0] > 16 || t.events[1] > 16 || t.critical != 2)
+    abort ();
+  return 0;
+}
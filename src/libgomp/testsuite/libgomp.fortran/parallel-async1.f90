@@ -0,0 +1,25 @@
+! { dg-do run }
+
+subroutine work (n)
+  integer :: n
+!$omp atomic
+  n = n + 1
+end subroutine work
+
+  use omp_lib
+
+  external :: work
+  integer (gomp_parallel_handle_kind) :: h
+  integer :: n
+
+  n = 0
+  h = gomp_parallel_async (work, n, 3)
+  do while (.not. gomp_parallel_test (h))
+  end do
+  call gomp_parallel_wait (h)
+  if (n .ne. 3) call abort
+
+  h = gomp_parallel_async (work, n, 2_8)
+  call gomp_parallel_wait (h)
+  if (n .ne. 5) call abort
+end
@@ -0,0 +1,28 @@
+! { dg-do run }
+
+  use omp_lib
+
+  integer :: n, host
+
+  host = omp_get_num_devices ()
+  n = 0
+!$omp parallel reduction (+:n)
+  n = n + 1
+!$omp end parallel
+  if (n .ne. omp_get_max_threads ()) call abort
+
+  if (omp_pause_resource (omp_pause_soft, host) .ne. 0) call abort
+  if (omp_pause_resource (omp_pause_hard, host) .ne. 0) call abort
+  if (omp_pause_resource (omp_pause_hard, host + 1) .eq. 0) call abort
+  if (omp_pause_resource_all (omp_pause_hard) .ne. 0) call abort
+  if (gomp_prewarm (2) .ne. 0) call abort
+  if (gomp_prewarm (0_8) .ne. 0) call abort
+
+  n = 0
+!$omp parallel reduction (+:n)
+  n = n + 1
+  if (omp_pause_resource_all (omp_pause_soft) .eq. 0) call abort
+  if (gomp_prewarm (2) .eq. 0) call abort
+!$omp end parallel
+  if (n .ne. omp_get_max_threads ()) call abort
+end
@@ -0,0 +1,19 @@
+! { dg-do run }
+
+  use omp_lib
+
+  integer (8) :: v1, v2
+  integer :: i
+
+  v1 = 42
+  if (gomp_get_perf_counter (0, v1) .ne. -1) call abort
+  if (gomp_get_perf_counter (6, v1) .ne. -1) call abort
+  if (v1 .ne. 42) call abort
+
+  do i = gomp_perf_cycles, gomp_perf_context_switches
+    if (gomp_get_perf_counter (i, v1) .eq. 0) then
+      if (gomp_get_perf_counter (i, v2) .ne. 0) call abort
+      if (v2 .lt. v1) call abort
+    end if
+  end do
+end
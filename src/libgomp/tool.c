@@ -0,0 +1,228 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file contains the interface for performance tools.  A tool
+   registers callbacks with GOMP_tool_set_callback, and the runtime reports
+   its events to them through gomp_tool_event.  Tools can be loaded from
+   the shared objects listed in GOMP_TOOL.  The events also feed the
+   profiler of GOMP_PROFILE and the trace of GOMP_TRACE.  */
+
+#include "libgomp.h"
+#include <string.h>
+#ifdef HAVE_DLFCN_H
+# include <dlfcn.h>
+#endif
+
+#define GOMP_TOOL_EVENTS (gomp_tool_event_lock_release + 1)
+
+/* True if any callback is registered or GOMP_PROFILE or GOMP_TRACE is
+   enabled.  */
+bool gomp_tool_enabled;
+
+static gomp_tool_callback_t gomp_tool_callbacks[GOMP_TOOL_EVENTS];
+static gomp_mutex_t gomp_tool_lock;
+
+/* A tool loaded from GOMP_TOOL that has a finalizer.  */
+
+struct gomp_tool
+{
+  struct gomp_tool *next;
+  void (*finalize) (void);
+};
+
+static struct gomp_tool *gomp_tools;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_tool (void)
+{
+  gomp_mutex_init (&gomp_tool_lock);
+}
+#endif
+
+/* Pass EVENT to the profiler and call the callback registered for it, if
+   any.  */
+
+void
+gomp_tool_dispatch (int event, const void *object, unsigned long arg0,
+		    unsigned long arg1)
+{
+  gomp_tool_callback_t callback
+    = __atomic_load_n (&gomp_tool_callbacks[event], MEMMODEL_ACQUIRE);
+
+  if (gomp_profile_enabled)
+    gomp_profile_event (event, object, arg0, arg1);
+  if (gomp_trace_enabled)
+    gomp_trace_event (event, object, arg0, arg1);
+  if (callback != NULL)
+    callback (event, object, arg0, arg1);
+}
+
+/* Report the start of the implicit task of thread ID in TEAM, which runs
+   FN, and, if the team runs a combined parallel loop or sections
+   construct, the start of its work share.  */
+
+void
+gomp_tool_implicit_task_begin (struct gomp_team *team, unsigned id,
+			       void (*fn) (void *))
+{
+  gomp_tool_dispatch (gomp_tool_event_implicit_task_begin, team, id,
+		      (unsigned long) fn);
+  if (team->tool_work_kind >= 0)
+    gomp_tool_dispatch (gomp_tool_event_work_begin, &team->work_shares[0],
+			team->tool_work_kind, team->tool_work_chunk);
+}
+
+/* Report the end of the work share of the calling thread, before it
+   leaves it, ended by the call returning to SITE.  If BARRIER, the thread
+   then waits in the barrier of the construct.  */
+
+void
+gomp_tool_work_end (void *site, bool barrier)
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  gomp_tool_dispatch (gomp_tool_event_work_end, thr->ts.work_share,
+		      (unsigned long) site, 0);
+  if (barrier)
+    thr->tool_site = site;
+}
+
+/* Report a wait in the team barrier BAR, at the construct recorded in
+   tool_site, or at the end of the parallel region if none is.  */
+
+void
+gomp_tool_barrier_wait_begin (gomp_barrier_t *bar)
+{
+  gomp_tool_dispatch (gomp_tool_event_barrier_wait_begin, bar,
+		      (unsigned long) gomp_thread ()->tool_site, 0);
+}
+
+void
+gomp_tool_barrier_wait_end (gomp_barrier_t *bar)
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  gomp_tool_dispatch (gomp_tool_event_barrier_wait_end, bar,
+		      (unsigned long) thr->tool_site, 0);
+  thr->tool_site = NULL;
+}
+
+/* Report that omp_test_lock or omp_test_nest_lock, called from CALLER,
+   took LOCK of kind KIND, as a wait that found it free.  */
+
+void
+gomp_tool_lock_tested (const void *lock, int kind, unsigned long caller)
+{
+  gomp_tool_lock_tried (true);
+  gomp_tool_dispatch (gomp_tool_event_lock_wait_begin, lock, kind, caller);
+  gomp_tool_dispatch (gomp_tool_event_lock_wait_end, lock, kind, caller);
+}
+
+/* Load the tools listed in GOMP_TOOL, separated by colons, and call
+   their GOMP_tool_initialize entry points.  */
+
+void
+gomp_init_tool (void)
+{
+#ifdef HAVE_DLFCN_H
+  char *list = gomp_tool_var;
+
+  while (*list != '\0')
+    {
+      size_t len = strcspn (list, ":");
+      char *name = gomp_alloca (len + 1);
+      void (*initialize) (void);
+      struct gomp_tool *tool;
+      void *handle;
+
+      memcpy (name, list, len);
+      name[len] = '\0';
+      list += len;
+      if (*list == ':')
+	list++;
+      if (len == 0)
+	continue;
+
+      handle = dlopen (name, RTLD_NOW);
+      if (handle == NULL)
+	{
+	  gomp_error ("Cannot load tool %s: %s", name, dlerror ());
+	  continue;
+	}
+      initialize = (void (*) (void)) dlsym (handle, "GOMP_tool_initialize");
+      if (initialize == NULL)
+	{
+	  gomp_error ("Tool %s has no GOMP_tool_initialize function", name);
+	  dlclose (handle);
+	  continue;
+	}
+      tool = gomp_malloc (sizeof (*tool));
+      tool->finalize = (void (*) (void)) dlsym (handle, "GOMP_tool_finalize");
+      tool->next = gomp_tools;
+      gomp_tools = tool;
+      initialize ();
+    }
+#else
+  gomp_error ("GOMP_TOOL is not supported on this system");
+#endif
+}
+
+/* Let the tools loaded from GOMP_TOOL report their results.  */
+
+static void __attribute__((destructor))
+gomp_tool_fini (void)
+{
+  struct gomp_tool *tool;
+
+  for (tool = gomp_tools; tool != NULL; tool = tool->next)
+    if (tool->finalize != NULL)
+      tool->finalize ();
+}
+
+
+/* The public API.  */
+
+/* Register CALLBACK for EVENT, replacing any earlier one, or remove the
+   callback of EVENT if CALLBACK is NULL.  Return 0 on success, or -1 if
+   EVENT is invalid.  */
+
+int
+GOMP_tool_set_callback (gomp_tool_event_t event,
+			gomp_tool_callback_t callback)
+{
+  bool enabled = gomp_profile_enabled || gomp_trace_enabled;
+  int i;
+
+  if (event < gomp_tool_event_parallel_begin || event >= GOMP_TOOL_EVENTS)
+    return -1;
+
+  gomp_mutex_lock (&gomp_tool_lock);
+  __atomic_store_n (&gomp_tool_callbacks[event], callback, MEMMODEL_RELEASE);
+  for (i = gomp_tool_event_parallel_begin; i < GOMP_TOOL_EVENTS; i++)
+    if (gomp_tool_callbacks[i] != NULL)
+      enabled = true;
+  __atomic_store_n (&gomp_tool_enabled, enabled, MEMMODEL_RELEASE);
+  gomp_mutex_unlock (&gomp_tool_lock);
+  return 0;
+}
@@ -0,0 +1,420 @@
+/* Copyright (C) 2015 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file contains the timeline trace enabled by GOMP_TRACE.  Each
+   thread appends the events of the tool interface to a ring buffer of its
+   own, which only it writes, so recording takes no lock.  When the
+   program exits, the buffers are written out as a JSON trace in the
+   Chrome trace event format, which Perfetto and chrome://tracing
+   display as one timeline per thread.  */
+
+#include "libgomp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Ends the chunk of a loop a thread was running, when it asks for the
+   next one or leaves the construct.  No event of the tool interface is
+   0.  */
+#define GOMP_TRACE_CHUNK_END 0
+
+/* Entries of the cache of symbol names, a power of 2.  */
+#define GOMP_TRACE_SYMBOLS 64
+
+struct gomp_trace_record
+{
+  uint64_t ticks;
+  const void *object;
+  unsigned long arg0, arg1;
+  int event;
+};
+
+struct gomp_trace_thread
+{
+  /* All the buffers, and the buffers of exited threads.  */
+  struct gomp_trace_thread *next, *next_free;
+  /* Number of the thread in the trace.  */
+  unsigned int id;
+  /* Whether the last chunk and lock wait of the thread were sampled.  */
+  bool chunk_open, lock_sampled;
+  /* Chunks and lock waits seen, for sampling.  */
+  unsigned long seen;
+  /* Events recorded so far, of which the last gomp_trace_buffer_var are
+     kept.  */
+  unsigned long head;
+  struct gomp_trace_record records[];
+};
+
+bool gomp_trace_enabled;
+static struct gomp_trace_thread *gomp_trace_threads;
+static struct gomp_trace_thread *gomp_trace_free;
+static unsigned int gomp_trace_nthreads;
+static gomp_mutex_t gomp_trace_lock;
+static uint64_t gomp_trace_start_ticks;
+static double gomp_trace_start_time;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_trace (void)
+{
+  gomp_mutex_init (&gomp_trace_lock);
+}
+#endif
+
+static struct gomp_trace_thread *
+gomp_trace_thread (void)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_trace_thread *tt = thr->trace;
+
+  if (__builtin_expect (tt == NULL, 0))
+    {
+      gomp_mutex_lock (&gomp_trace_lock);
+      tt = gomp_trace_free;
+      if (tt != NULL)
+	gomp_trace_free = tt->next_free;
+      else
+	{
+	  tt = gomp_malloc_cleared (sizeof (*tt) + gomp_trace_buffer_var
+						   * sizeof (tt->records[0]));
+	  tt->id = gomp_trace_nthreads++;
+	  tt->next = gomp_trace_threads;
+	  gomp_trace_threads = tt;
+	}
+      gomp_mutex_unlock (&gomp_trace_lock);
+      thr->trace = tt;
+      gomp_free_thread_at_exit (thr);
+    }
+  return tt;
+}
+
+/* Called when THR exits.  Its buffer goes on the free list, and the
+   next thread to start appends its events to it, on the same timeline,
+   rather than every thread of a program that keeps creating threads
+   getting a buffer of its own.  */
+
+void
+gomp_trace_free_thread (struct gomp_thread *thr)
+{
+  struct gomp_trace_thread *tt = thr->trace;
+
+  if (tt == NULL)
+    return;
+  thr->trace = NULL;
+  tt->chunk_open = false;
+  tt->lock_sampled = false;
+  gomp_mutex_lock (&gomp_trace_lock);
+  tt->next_free = gomp_trace_free;
+  gomp_trace_free = tt;
+  gomp_mutex_unlock (&gomp_trace_lock);
+}
+
+static inline void
+gomp_trace_record (struct gomp_trace_thread *tt, int event,
+		   const void *object, unsigned long arg0, unsigned long arg1)
+{
+  unsigned long head = tt->head;
+  struct gomp_trace_record *r = &tt->records[head % gomp_trace_buffer_var];
+
+  r->ticks = gomp_profile_ticks ();
+  r->object = object;
+  r->arg0 = arg0;
+  r->arg1 = arg1;
+  r->event = event;
+  __atomic_store_n (&tt->head, head + 1, MEMMODEL_RELEASE);
+}
+
+/* Return true if the next chunk or lock wait is to be recorded.  */
+
+static inline bool
+gomp_trace_sample (struct gomp_trace_thread *tt)
+{
+  return tt->seen++ % gomp_trace_sampling_var == 0;
+}
+
+/* Record EVENT of the tool interface, see GOMP_tool_set_callback for the
+   arguments.  */
+
+void
+gomp_trace_event (int event, const void *object, unsigned long arg0,
+		  unsigned long arg1)
+{
+  struct gomp_trace_thread *tt = gomp_trace_thread ();
+
+  switch (event)
+    {
+    case gomp_tool_event_task_create:
+    case gomp_tool_event_lock_release:
+      return;
+
+    case gomp_tool_event_work_chunk:
+      if (tt->chunk_open)
+	gomp_trace_record (tt, GOMP_TRACE_CHUNK_END, object, 0, 0);
+      tt->chunk_open = gomp_trace_sample (tt);
+      if (!tt->chunk_open)
+	return;
+      break;
+
+    case gomp_tool_event_work_end:
+    case gomp_tool_event_implicit_task_end:
+      if (tt->chunk_open)
+	gomp_trace_record (tt, GOMP_TRACE_CHUNK_END, object, 0, 0);
+      tt->chunk_open = false;
+      break;
+
+    case gomp_tool_event_lock_wait_begin:
+      tt->lock_sampled = gomp_trace_sample (tt);
+      /* FALLTHRU */
+    case gomp_tool_event_lock_wait_end:
+      if (!tt->lock_sampled)
+	return;
+      break;
+    }
+  gomp_trace_record (tt, event, object, arg0, arg1);
+}
+
+/* Start tracing.  */
+
+void
+gomp_init_trace (void)
+{
+  gomp_trace_start_time = omp_get_wtime ();
+  gomp_trace_start_ticks = gomp_profile_ticks ();
+  gomp_trace_enabled = true;
+  gomp_tool_enabled = true;
+}
+
+
+/* Writing the trace.  */
+
+struct gomp_trace_symbol
+{
+  const void *addr;
+  char name[128];
+};
+
+static struct gomp_trace_symbol *gomp_trace_symbols;
+
+/* Return the name of the function or call site at ADDR.  */
+
+static const char *
+gomp_trace_symbol (const void *addr)
+{
+  struct gomp_trace_symbol *s
+    = &gomp_trace_symbols[((uintptr_t) addr >> 4) & (GOMP_TRACE_SYMBOLS - 1)];
+
+  if (s->addr != addr || s->name[0] == '\0')
+    {
+      s->addr = addr;
+      gomp_profile_symbol (s->name, sizeof (s->name), addr);
+    }
+  return s->name;
+}
+
+/* Write STR to F as the contents of a JSON string.  */
+
+static void
+gomp_trace_print_string (FILE *f, const char *str)
+{
+  for (; *str; str++)
+    if (*str == '"' || *str == '\\')
+      fprintf (f, "\\%c", *str);
+    else if ((unsigned char) *str < ' ')
+      fprintf (f, "\\u%04x", *str);
+    else
+      fputc (*str, f);
+}
+
+/* Write record R of thread TT to F, as the beginning of a slice if BEGIN,
+   else as its end.  */
+
+static void
+gomp_trace_print_record (FILE *f, struct gomp_trace_thread *tt,
+			 struct gomp_trace_record *r, bool begin,
+			 double tick_us, unsigned long pid)
+{
+  static const char *const sched_names[] =
+    { "sections", "static", "dynamic", "guided", "binlpt", "srr", "auto" };
+  static const char *const mutex_names[] =
+    { "lock", "nest lock", "critical", "ordered", "atomic" };
+
+  fprintf (f, ",\n{\"ph\":\"%c\",\"pid\":%lu,\"tid\":%u,\"ts\":%.3f",
+	   begin ? 'B' : 'E', pid, tt->id,
+	   (double) (r->ticks - gomp_trace_start_ticks) * tick_us);
+  switch (r->event)
+    {
+    case gomp_tool_event_parallel_begin:
+      fputs (",\"name\":\"parallel ", f);
+      gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg1));
+      fprintf (f, "\",\"args\":{\"threads\":%lu}", r->arg0);
+      break;
+    case gomp_tool_event_implicit_task_begin:
+      fputs (",\"name\":\"implicit task ", f);
+      gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg1));
+      fprintf (f, "\",\"args\":{\"thread\":%lu}", r->arg0);
+      break;
+    case gomp_tool_event_task_schedule:
+      fputs (",\"name\":\"task ", f);
+      gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg0));
+      fputc ('"', f);
+      break;
+    case gomp_tool_event_work_begin:
+      if (r->arg0 == 0)
+	fprintf (f, ",\"name\":\"sections\",\"args\":{\"sections\":%lu}",
+		 r->arg1);
+      else
+	fprintf (f, ",\"name\":\"loop\",\"args\":{\"schedule\":\"%s\","
+		 "\"chunk\":%ld}",
+		 r->arg0 < sizeof (sched_names) / sizeof (sched_names[0])
+		 ? sched_names[r->arg0] : "?", (long) r->arg1);
+      break;
+    case gomp_tool_event_work_end:
+      fputs (",\"args\":{\"site\":\"", f);
+      gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg0));
+      fputs ("\"}", f);
+      break;
+    case gomp_tool_event_work_chunk:
+      fprintf (f, ",\"name\":\"chunk\",\"args\":{\"start\":%ld,"
+		  "\"end\":%ld}", (long) r->arg0, (long) r->arg1);
+      break;
+    case gomp_tool_event_barrier_wait_begin:
+      if (r->arg0 == 0)
+	fputs (",\"name\":\"join\"", f);
+      else
+	{
+	  fputs (",\"name\":\"barrier ", f);
+	  gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg0));
+	  fputc ('"', f);
+	}
+      break;
+    case gomp_tool_event_lock_wait_begin:
+      fprintf (f, ",\"name\":\"%s wait\",\"args\":{\"site\":\"",
+	       r->arg0 - gomp_tool_mutex_lock
+	       < sizeof (mutex_names) / sizeof (mutex_names[0])
+	       ? mutex_names[r->arg0 - gomp_tool_mutex_lock] : "lock");
+      gomp_trace_print_string (f, gomp_trace_symbol ((void *) r->arg1));
+      fputs ("\"}", f);
+      break;
+    }
+  fputc ('}', f);
+}
+
+/* Open the file named by GOMP_TRACE, in which %p stands for the process
+   ID.  */
+
+static FILE *
+gomp_trace_open (void)
+{
+  const char *p = strstr (gomp_trace_var, "%p");
+  char *name;
+  FILE *f;
+
+  name = gomp_alloca (strlen (gomp_trace_var) + 3 * sizeof (pid_t));
+  if (p != NULL)
+    sprintf (name, "%.*s%lu%s", (int) (p - gomp_trace_var),
+	     gomp_trace_var, (unsigned long) getpid (), p + 2);
+  else
+    strcpy (name, gomp_trace_var);
+  f = fopen (name, "w");
+  if (f == NULL)
+    gomp_error ("Cannot open GOMP_TRACE file %s", name);
+  return f;
+}
+
+/* Write the buffers of all threads to the trace file.  */
+
+static void __attribute__((destructor))
+gomp_trace_fini (void)
+{
+  struct gomp_trace_thread *tt;
+  unsigned long pid = getpid ();
+  uint64_t elapsed;
+  double tick_us;
+  FILE *f;
+
+  if (!gomp_trace_enabled)
+    return;
+  gomp_trace_enabled = false;
+
+  elapsed = gomp_profile_ticks () - gomp_trace_start_ticks;
+  tick_us = elapsed ? (omp_get_wtime () - gomp_trace_start_time) * 1e6
+		      / elapsed : 1e-3;
+
+  f = gomp_trace_open ();
+  if (f == NULL)
+    return;
+  gomp_trace_symbols
+    = gomp_malloc_cleared (GOMP_TRACE_SYMBOLS * sizeof (*gomp_trace_symbols));
+
+  fprintf (f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+	   "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%lu,"
+	   "\"args\":{\"name\":\"libgomp\"}}", pid);
+  gomp_mutex_lock (&gomp_trace_lock);
+  for (tt = gomp_trace_threads; tt != NULL; tt = tt->next)
+    {
+      unsigned long head = __atomic_load_n (&tt->head, MEMMODEL_ACQUIRE);
+      unsigned long i = head > gomp_trace_buffer_var
+			? head - gomp_trace_buffer_var : 0;
+      /* Slices still open, so that the ends of slices whose beginning was
+	 overwritten in the ring buffer are left out.  */
+      unsigned long depth = 0;
+
+      fprintf (f, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%lu,"
+	       "\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+	       pid, tt->id, tt->id);
+      for (; i < head; i++)
+	{
+	  struct gomp_trace_record *r
+	    = &tt->records[i % gomp_trace_buffer_var];
+	  bool begin;
+
+	  switch (r->event)
+	    {
+	    case gomp_tool_event_parallel_begin:
+	    case gomp_tool_event_implicit_task_begin:
+	    case gomp_tool_event_task_schedule:
+	    case gomp_tool_event_work_begin:
+	    case gomp_tool_event_work_chunk:
+	    case gomp_tool_event_barrier_wait_begin:
+	    case gomp_tool_event_lock_wait_begin:
+	      begin = true;
+	      break;
+	    default:
+	      begin = false;
+	      break;
+	    }
+	  if (begin)
+	    depth++;
+	  else if (depth == 0)
+	    continue;
+	  else
+	    depth--;
+	  gomp_trace_print_record (f, tt, r, begin, tick_us, pid);
+	}
+    }
+  gomp_mutex_unlock (&gomp_trace_lock);
+  fputs ("\n]}\n", f);
+  fclose (f);
+  free (gomp_trace_symbols);
+}